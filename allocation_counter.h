@@ -0,0 +1,163 @@
+ /**
+ ******************************************************************************
+ *
+ *  Counting of heap allocations for tests and benchmarks
+ *
+ *  This header replaces the global operator new and operator delete and must
+ *  therefore be included in exactly one translation unit of an executable.
+ *
+ ******************************************************************************
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <memory_resource>
+#include <malloc.h>
+
+#include "instrumentation.h"
+
+namespace CP {
+
+/*******************************************
+ * AllocationCounter
+ ******************************************/
+
+/**
+ * @brief Counts all allocations made by any overload of the global operator new of all threads.
+ *
+ * The allocations are also counted by the counter ALLOCATIONS of the instrumentation if CP_INSTRUMENTATION is defined.
+ */
+struct AllocationCounter {
+  inline static std::atomic<size_t> allocations = 0;
+  inline static std::atomic<size_t> allocatedBytes = 0;
+  inline static std::atomic<size_t> liveBytes = 0;
+  inline static std::atomic<size_t> peakBytes = 0;
+
+  inline static void* allocate(size_t size, size_t alignment = __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+    void* pointer = tryAllocate(size, alignment);
+    if ( !pointer ) {
+      throw std::bad_alloc();
+    }
+    return pointer;
+  }
+
+  /**
+   * @brief Allocates and counts memory with the given alignment, or returns nullptr if no memory is available.
+   */
+  inline static void* tryAllocate(size_t size, size_t alignment = __STDCPP_DEFAULT_NEW_ALIGNMENT__) noexcept {
+    size = size ? size : 1;
+    void* pointer = ( alignment <= __STDCPP_DEFAULT_NEW_ALIGNMENT__ )
+      ? std::malloc(size)
+      : std::aligned_alloc(alignment, ( size + alignment - 1 ) / alignment * alignment)
+    ;
+    if ( !pointer ) {
+      return nullptr;
+    }
+    size_t usable = malloc_usable_size(pointer);
+    CP_COUNT(ALLOCATIONS, 1);
+    allocations++;
+    allocatedBytes += usable;
+    size_t live = liveBytes += usable;
+    size_t peak = peakBytes;
+    while ( live > peak && !peakBytes.compare_exchange_weak(peak, live) ) {}
+    return pointer;
+  }
+
+  inline static void deallocate(void* pointer) {
+    if ( pointer ) {
+      liveBytes -= malloc_usable_size(pointer);
+      std::free(pointer);
+    }
+  }
+};
+
+/**
+ * @brief Measures the allocations made between its construction and the calls of its accessors.
+ */
+class AllocationScope {
+public:
+  inline AllocationScope()
+    : allocationsBefore(AllocationCounter::allocations)
+    , bytesBefore(AllocationCounter::allocatedBytes)
+    , liveBefore(AllocationCounter::liveBytes)
+  {
+    AllocationCounter::peakBytes = liveBefore;
+  };
+
+  inline size_t allocations() const { return AllocationCounter::allocations - allocationsBefore; };
+  inline size_t allocatedBytes() const { return AllocationCounter::allocatedBytes - bytesBefore; };
+  /**
+   * @brief Returns the maximal growth of the heap since construction, assuming that no other scope was created in between.
+   */
+  inline size_t peakBytes() const { return AllocationCounter::peakBytes - liveBefore; };
+
+private:
+  size_t allocationsBefore;
+  size_t bytesBefore;
+  size_t liveBefore;
+};
+
+/*******************************************
+ * CountingResource
+ ******************************************/
+
+/**
+ * @brief Memory resource forwarding to an upstream resource and counting the allocations made through it.
+ */
+class CountingResource : public std::pmr::memory_resource {
+public:
+  inline CountingResource(std::pmr::memory_resource* upstream = std::pmr::get_default_resource()) : upstream(upstream) {};
+
+  inline size_t allocations() const { return _allocations; };
+  inline size_t allocatedBytes() const { return _allocatedBytes; };
+  inline size_t liveBytes() const { return _liveBytes; };
+
+private:
+  std::pmr::memory_resource* upstream;
+  std::atomic<size_t> _allocations = 0;
+  std::atomic<size_t> _allocatedBytes = 0;
+  std::atomic<size_t> _liveBytes = 0;
+
+  inline void* do_allocate(size_t bytes, size_t alignment) override {
+    void* pointer = upstream->allocate(bytes, alignment);
+    _allocations++;
+    _allocatedBytes += bytes;
+    _liveBytes += bytes;
+    return pointer;
+  }
+
+  inline void do_deallocate(void* pointer, size_t bytes, size_t alignment) override {
+    upstream->deallocate(pointer, bytes, alignment);
+    _liveBytes -= bytes;
+  }
+
+  inline bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+    return this == &other;
+  }
+};
+
+} // end namespace CP
+
+void* operator new(size_t size) { return CP::AllocationCounter::allocate(size); }
+void* operator new[](size_t size) { return CP::AllocationCounter::allocate(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return CP::AllocationCounter::tryAllocate(size); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return CP::AllocationCounter::tryAllocate(size); }
+void* operator new(size_t size, std::align_val_t alignment) { return CP::AllocationCounter::allocate(size, (size_t)alignment); }
+void* operator new[](size_t size, std::align_val_t alignment) { return CP::AllocationCounter::allocate(size, (size_t)alignment); }
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return CP::AllocationCounter::tryAllocate(size, (size_t)alignment); }
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return CP::AllocationCounter::tryAllocate(size, (size_t)alignment); }
+void operator delete(void* pointer) noexcept { CP::AllocationCounter::deallocate(pointer); }
+void operator delete[](void* pointer) noexcept { CP::AllocationCounter::deallocate(pointer); }
+void operator delete(void* pointer, size_t) noexcept { CP::AllocationCounter::deallocate(pointer); }
+void operator delete[](void* pointer, size_t) noexcept { CP::AllocationCounter::deallocate(pointer); }
+void operator delete(void* pointer, const std::nothrow_t&) noexcept { CP::AllocationCounter::deallocate(pointer); }
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept { CP::AllocationCounter::deallocate(pointer); }
+void operator delete(void* pointer, std::align_val_t) noexcept { CP::AllocationCounter::deallocate(pointer); }
+void operator delete[](void* pointer, std::align_val_t) noexcept { CP::AllocationCounter::deallocate(pointer); }
+void operator delete(void* pointer, size_t, std::align_val_t) noexcept { CP::AllocationCounter::deallocate(pointer); }
+void operator delete[](void* pointer, size_t, std::align_val_t) noexcept { CP::AllocationCounter::deallocate(pointer); }
+void operator delete(void* pointer, std::align_val_t, const std::nothrow_t&) noexcept { CP::AllocationCounter::deallocate(pointer); }
+void operator delete[](void* pointer, std::align_val_t, const std::nothrow_t&) noexcept { CP::AllocationCounter::deallocate(pointer); }
@@ -0,0 +1,159 @@
+#include <iostream>
+#include <chrono>
+#include <sys/resource.h>
+
+#include "cp.h"
+#include "generator.h"
+#include "feasibility_checker.h"
+#include "thread_pool.h"
+#include "portfolio.h"
+#include "allocation_counter.h"
+
+#define USE_LIMEX
+#ifdef USE_LIMEX
+  #include "limex_callables.h"
+#endif
+
+/*******************************************
+ * Harness
+ ******************************************/
+
+bool first = true; ///< Whether no entry was printed yet, shared by all instantiations of run()
+
+/**
+ * @brief Runs a benchmark once and prints time, number and bytes of allocations, peak heap growth, and peak resident memory as JSON.
+ */
+template<typename Function>
+void run(const std::string& name, size_t size, Function&& function) {
+  CP::AllocationScope scope;
+
+  auto start = std::chrono::steady_clock::now();
+  function();
+  auto end = std::chrono::steady_clock::now();
+
+  rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  std::cout << ( first ? "  " : ", " ) << std::format(
+    "{{ \"name\": \"{}\", \"size\": {}, \"seconds\": {:.6f}, \"allocations\": {}, \"allocatedBytes\": {}, \"peakHeapBytes\": {}, \"peakResidentKiB\": {} }}",
+    name, size, std::chrono::duration<double>(end - start).count(),
+    scope.allocations(), scope.allocatedBytes(), scope.peakBytes(), usage.ru_maxrss
+  ) << std::endl;
+  first = false;
+}
+
+int main(int argc, char** argv)
+{
+  size_t maxSize = argc > 1 ? std::stoul(argv[1]) : 1000000;
+  // chains are copied whenever they are extended, which makes their construction quadratic
+  size_t maxChainSize = std::min<size_t>(maxSize, 1000);
+  // the number of nodes explored by the portfolio, which synchronizes its workers every 1000 nodes in deterministic mode
+  size_t maxNodes = std::min<size_t>(maxSize, 100000);
+
+  CP::ThreadPool pool;
+
+  std::cout << "[" << std::endl;
+  for ( size_t size = 10; size <= maxSize; size *= 10 ) {
+    CP::Model model;
+    auto& x = model.addRealVariable("x");
+    auto& y = model.addBinaryVariable("y");
+    std::vector<CP::Expression> terms;
+    for ( size_t i = 0; i < size; i++ ) {
+      terms.push_back( x * (double)i );
+    }
+
+    if ( size <= maxChainSize ) {
+      run("chain", size, [&]() {
+        CP::Expression result(0.0);
+        for ( size_t i = 0; i < size; i++ ) {
+          result = result + x;
+        }
+      });
+    }
+
+    run("max", size, [&]() {
+      auto result = CP::max(terms);
+    });
+
+    run("min", size, [&]() {
+      auto result = CP::min(terms);
+    });
+
+    run("n_ary_if", size, [&]() {
+      CP::Cases cases;
+      cases.reserve(size);
+      for ( size_t i = 0; i < size; i++ ) {
+        cases.push_back( { x == (double)i, y + (double)i } );
+      }
+      auto result = CP::n_ary_if( std::move(cases), 0.0 );
+    });
+
+    run("IndexedVariables::emplace_back", size, [&]() {
+      auto& a = model.addIndexedVariables(CP::Variable::Type::INTEGER, "a");
+      for ( size_t i = 0; i < size; i++ ) {
+        a.emplace_back(0, (double)i);
+      }
+    });
+
+    run("Model::addSequence", size, [&]() {
+      model.addSequence("s", size);
+    });
+
+    for ( size_t i = 0; i < size; i++ ) {
+      model.addConstraint( x + (double)i <= 3 * y );
+    }
+    run("Model::stringify", size, [&]() {
+      auto result = model.stringify();
+    });
+
+    CP::Model generated;
+    run("generateSchedulingModel", size, [&]() {
+      CP::GeneratorParameters parameters;
+      parameters.processes = std::max<size_t>(1, size / parameters.activities);
+      CP::generateSchedulingModel(generated, parameters);
+    });
+
+    CP::FeasibilityChecker checker(generated);
+    std::vector<double> values(checker.getInputs().size(), 1.0);
+    run("FeasibilityChecker::violations", size, [&]() {
+      auto result = checker.violations(values);
+    });
+    run("FeasibilityChecker::violations (parallel)", size, [&]() {
+      auto result = checker.violations(values, pool);
+    });
+
+    if ( size <= maxNodes ) {
+      CP::Model knapsack(CP::Model::ObjectiveSense::MAXIMIZE);
+      auto& item = knapsack.addIndexedVariables(CP::Variable::Type::INTEGER, "item");
+      CP::Expression weight(0.0), profit(0.0);
+      for ( size_t i = 0; i < 30; i++ ) {
+        item.emplace_back(0, 5);
+        weight = weight + (double)(3 + i % 7) * item[i];
+        profit = profit + (double)(4 + i % 5) * item[i];
+      }
+      knapsack.addConstraint( weight <= 200 );
+      knapsack.setObjective( profit );
+      for ( auto mode : { CP::Portfolio::Mode::DETERMINISTIC, CP::Portfolio::Mode::NONDETERMINISTIC } ) {
+        CP::Portfolio portfolio(knapsack, pool);
+        portfolio.setMode(mode);
+        run(mode == CP::Portfolio::Mode::DETERMINISTIC ? "Portfolio::solve (deterministic)" : "Portfolio::solve (nondeterministic)", size, [&]() {
+          auto result = portfolio.solve(std::chrono::seconds(60), size);
+        });
+      }
+    }
+
+#ifdef USE_LIMEX
+    std::string elements;
+    for ( size_t i = 0; i < size; i++ ) {
+      elements += ( i ? ", " : "" ) + std::to_string(i);
+    }
+    LIMEX::Callables<CP::Expression> callables;
+    run("LIMEX lowering", size, [&]() {
+      auto expression = LIMEX::Expression<CP::Expression>("x in {" + elements + "}", callables);
+      auto result = expression.evaluate({x});
+    });
+#endif
+  }
+  std::cout << "]" << std::endl;
+
+  return 0;
+}
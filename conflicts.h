@@ -0,0 +1,212 @@
+ /**
+ ******************************************************************************
+ *
+ *  Extraction of minimal conflicts of infeasible models
+ *
+ ******************************************************************************
+ */
+
+#pragma once
+
+#include <cmath>
+#include <algorithm>
+#include <numeric>
+
+#include "cp.h"
+#include "tape.h"
+#include "feasibility_checker.h"
+#include "thread_pool.h"
+
+namespace CP {
+
+/*******************************************
+ * ConflictAnalyzer
+ ******************************************/
+
+/**
+ * @brief Determines irreducible infeasible subsets (IIS) of the hard constraints of a model.
+ *
+ * The constraints are numbered like in FeasibilityChecker. A set of constraints is considered infeasible if interval
+ * propagation, i.e. repeated narrowing of the bounds of the variables by each constraint, yields empty bounds. As this
+ * test is incomplete, a conflict is only found if propagation detects the infeasibility of the model. Removing a
+ * constraint from a set never makes propagation detect an infeasibility, so that the returned conflicts are irreducible
+ * with respect to the test.
+ */
+class ConflictAnalyzer {
+public:
+  /**
+   * @param maxRounds The maximal number of rounds narrowing the bounds by all constraints of a set.
+   */
+  inline ConflictAnalyzer(const Model& model, size_t maxRounds = 100) : checker(model), tape(checker.getTape()), maxRounds(maxRounds) {};
+
+  inline size_t size() const { return checker.size(); };
+  inline std::string stringify(size_t constraint) const { return checker.stringify(constraint); };
+
+  /**
+   * @brief Returns the constraints of a conflict, one per line.
+   */
+  inline std::string stringify(const std::vector<size_t>& conflict) const {
+    std::string result;
+    for ( size_t constraint : conflict ) {
+      result += stringify(constraint) + "\n";
+    }
+    return result;
+  }
+
+  /**
+   * @brief Returns true if propagation proves that the constraints cannot be satisfied together.
+   */
+  inline bool isInfeasible(const std::vector<size_t>& constraints) { return isInfeasible(constraints, getBounds(tape), tape); };
+
+  /**
+   * @brief Returns true if propagation proves that the constraints cannot be satisfied together within the given bounds of the inputs.
+   *
+   * @param bounds The bounds of the inputs in the order of FeasibilityChecker::getInputs().
+   */
+  inline bool isInfeasible(const std::vector<size_t>& constraints, std::vector<Interval> bounds) { return isInfeasible(constraints, std::move(bounds), tape); };
+
+  /**
+   * @brief Narrows the bounds of the inputs by rounds of narrowing with each constraint and returns false if the bounds become empty.
+   *
+   * @param evaluator A copy of the tape of the checker, so that different threads can propagate concurrently.
+   * @param conflict If not null, set to the constraint whose narrowing yields empty bounds.
+   */
+  inline bool propagate(const std::vector<size_t>& constraints, std::vector<Interval>& bounds, Tape& evaluator, size_t* conflict = nullptr) const {
+    std::vector<Interval> previous;
+    for ( size_t round = 0; round < maxRounds; round++ ) {
+      previous = bounds;
+      for ( size_t constraint : constraints ) {
+        if ( !evaluator.narrow(checker.getOutput(constraint), { 0.0, 0.0 }, bounds) ) {
+          if ( conflict ) {
+            *conflict = constraint;
+          }
+          return false;
+        }
+      }
+      // stop if no bound changed significantly
+      bool changed = false;
+      for ( size_t i = 0; i < bounds.size() && !changed; i++ ) {
+        changed = std::abs(bounds[i].lowerBound - previous[i].lowerBound) > 1e-6 * std::max(1.0, std::abs(previous[i].lowerBound))
+          || std::abs(bounds[i].upperBound - previous[i].upperBound) > 1e-6 * std::max(1.0, std::abs(previous[i].upperBound));
+      }
+      if ( !changed ) {
+        break;
+      }
+    }
+    return true;
+  }
+
+  /**
+   * @brief Returns the feasibility checker numbering the constraints.
+   */
+  inline const FeasibilityChecker& getChecker() const { return checker; };
+
+  /**
+   * @brief Returns an irreducible infeasible subset of all constraints determined by divide and conquer (QuickXplain), or an empty set if no infeasibility is detected.
+   */
+  inline std::vector<size_t> quickXplain() {
+    std::vector<size_t> constraints(size());
+    std::iota(constraints.begin(), constraints.end(), 0);
+    if ( !isInfeasible(constraints) ) {
+      return {};
+    }
+    auto result = quickXplain({}, false, constraints);
+    std::sort(result.begin(), result.end());
+    return result;
+  }
+
+  /**
+   * @brief Returns an irreducible infeasible subset of all constraints determined by a deletion filter, or an empty set if no infeasibility is detected.
+   */
+  inline std::vector<size_t> deletionFilter(ThreadPool& pool) {
+    std::vector<size_t> constraints(size());
+    std::iota(constraints.begin(), constraints.end(), 0);
+    return deletionFilter(std::move(constraints), pool);
+  }
+
+  /**
+   * @brief Returns an irreducible infeasible subset of the given constraints determined by a deletion filter, or an empty set if no infeasibility is detected.
+   *
+   * The removals of as many constraints as the pool has threads are tested concurrently. If the first removable constraint
+   * is removed, the constraints tested before remain necessary, because removing constraints never makes a set infeasible.
+   */
+  inline std::vector<size_t> deletionFilter(std::vector<size_t> constraints, ThreadPool& pool) {
+    if ( !isInfeasible(constraints) ) {
+      return {};
+    }
+    tapes.resize(pool.size(), tape);
+    size_t necessary = 0; ///< Number of leading constraints known to be necessary
+    std::vector<char> removable;
+    while ( necessary < constraints.size() ) {
+      size_t batch = std::min(pool.size(), constraints.size() - necessary);
+      removable.assign(batch, false);
+      pool.run( batch, [&](size_t k) {
+        std::vector<size_t> remaining;
+        remaining.reserve(constraints.size() - 1);
+        for ( size_t i = 0; i < constraints.size(); i++ ) {
+          if ( i != necessary + k ) {
+            remaining.push_back(constraints[i]);
+          }
+        }
+        removable[k] = isInfeasible(remaining, getBounds(tapes[k]), tapes[k]);
+      } );
+      size_t first = (size_t)( std::find(removable.begin(), removable.end(), true) - removable.begin() );
+      necessary += first;
+      if ( first < batch ) {
+        constraints.erase(constraints.begin() + (long)necessary);
+      }
+    }
+    std::sort(constraints.begin(), constraints.end());
+    return constraints;
+  }
+
+private:
+  FeasibilityChecker checker;
+  Tape tape;
+  std::vector<Tape> tapes; ///< Tapes used by the threads of the deletion filter
+  size_t maxRounds;
+
+  inline static std::vector<Interval> getBounds(const Tape& evaluator) {
+    std::vector<Interval> bounds;
+    bounds.reserve(evaluator.getInputs().size());
+    for ( auto variable : evaluator.getInputs() ) {
+      bounds.push_back({ variable->lowerBound, variable->upperBound });
+    }
+    return bounds;
+  }
+
+  inline bool isInfeasible(const std::vector<size_t>& constraints, std::vector<Interval> bounds, Tape& evaluator) const {
+    return !propagate(constraints, bounds, evaluator);
+  }
+
+  /**
+   * @brief Returns a minimal subset of the constraints which is infeasible together with the background, assuming that background and constraints are infeasible.
+   *
+   * @param background Constraints assumed to be included.
+   * @param added True if constraints were added to the background since the last test.
+   * @param constraints Constraints from which the subset is chosen.
+   */
+  inline std::vector<size_t> quickXplain(const std::vector<size_t>& background, bool added, const std::vector<size_t>& constraints) {
+    if ( added && isInfeasible(background) ) {
+      return {};
+    }
+    if ( constraints.size() == 1 ) {
+      return constraints;
+    }
+    std::vector<size_t> first(constraints.begin(), constraints.begin() + (long)constraints.size() / 2);
+    std::vector<size_t> second(constraints.begin() + (long)constraints.size() / 2, constraints.end());
+
+    std::vector<size_t> extended = background;
+    extended.insert(extended.end(), first.begin(), first.end());
+    auto secondConflict = quickXplain(extended, !first.empty(), second);
+
+    extended = background;
+    extended.insert(extended.end(), secondConflict.begin(), secondConflict.end());
+    auto firstConflict = quickXplain(extended, !secondConflict.empty(), first);
+
+    firstConflict.insert(firstConflict.end(), secondConflict.begin(), secondConflict.end());
+    return firstConflict;
+  }
+};
+
+} // end namespace CP
@@ -10,17 +10,36 @@
 
 #include <memory>
 #include <list>
+#include <map>
+#include <unordered_map>
+#include <bit>
 #include <vector>
 #include <limits>
 #include <string>
 #include <format>
 #include <ranges>
 #include <variant>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <array>
+#include <optional>
+#include <stdexcept>
+
+#include "instrumentation.h"
 
 namespace CP {
 
 struct Expression;
 
+/**
+ * @brief Represents an interval of values, infinite bounds are represented by std::numeric_limits<double>::lowest() and std::numeric_limits<double>::max().
+ */
+struct Interval {
+  double lowerBound;
+  double upperBound;
+};
+
 /*******************************************
  * Variable
  ******************************************/
@@ -599,6 +618,371 @@ private:
   std::list<Variable> _variables;
 };
 
+/*******************************************
+ * Table
+ ******************************************/
+
+/**
+ * @brief Represents an extensional constraint requiring that a tuple of variables takes one of the allowed tuples or none of the forbidden tuples.
+ *
+ * The tuples are stored column by column. For each column the distinct values are sorted and each value has a bitset
+ * of the tuples supporting it, which allows membership checks and propagation by intersecting bitsets.
+ */
+struct Table {
+  enum class Type { ALLOWED, FORBIDDEN };
+
+  inline Table(std::vector<std::reference_wrapper<const Variable>> variables, const std::vector< std::vector<double> >& tuples, Type type = Type::ALLOWED)
+    : type(type)
+    , _size(tuples.size())
+    , _words( (tuples.size() + 63) / 64 )
+  {
+    for ( auto& variable : variables ) {
+      this->variables.push_back(variable);
+    }
+    _columns.resize(this->variables.size());
+    for ( size_t row = 0; row < tuples.size(); row++ ) {
+      if ( tuples[row].size() != this->variables.size() ) {
+        throw std::invalid_argument("CP: table requires tuples with one value per variable");
+      }
+    }
+    for ( size_t column = 0; column < _columns.size(); column++ ) {
+      auto& values = _columns[column].values;
+      values.reserve(tuples.size());
+      for ( auto& tuple : tuples ) {
+        values.push_back(tuple[column]);
+      }
+      std::sort(values.begin(), values.end());
+      values.erase( std::unique(values.begin(), values.end()), values.end() );
+      _columns[column].supports.assign(values.size() * _words, 0);
+      for ( size_t row = 0; row < tuples.size(); row++ ) {
+        size_t position = (size_t)( std::lower_bound(values.begin(), values.end(), tuples[row][column]) - values.begin() );
+        _columns[column].supports[position * _words + row / 64] |= (uint64_t)1 << (row % 64);
+      }
+      values.shrink_to_fit();
+    }
+  };
+  Table(const Table&) = delete; // Disable copy constructor
+  Table& operator=(const Table&) = delete; // Disable copy assignment
+
+  Type type;
+  reference_vector<const Variable> variables;
+
+  inline size_t size() const { return _size; };
+  inline size_t arity() const { return _columns.size(); };
+
+  /**
+   * @brief Returns the value of a column in a row of the table.
+   */
+  inline double value(size_t row, size_t column) const {
+    for ( size_t position = 0; position < _columns[column].values.size(); position++ ) {
+      if ( support(column, position)[row / 64] & ( (uint64_t)1 << (row % 64) ) ) {
+        return _columns[column].values[position];
+      }
+    }
+    throw std::logic_error("CP: unexpected row");
+  };
+
+  /**
+   * @brief Returns true if the tuple given by value(column) for each column is in the table.
+   */
+  template<typename Values>
+  inline bool contains(const Values& value) const {
+    // supports of the given values, tables of small arity do not require heap allocations
+    std::array<const uint64_t*, 16> buffer;
+    std::vector<const uint64_t*> overflow;
+    const uint64_t** supports = buffer.data();
+    if ( _columns.size() > buffer.size() ) {
+      overflow.resize(_columns.size());
+      supports = overflow.data();
+    }
+    for ( size_t column = 0; column < _columns.size(); column++ ) {
+      auto& values = _columns[column].values;
+      double x = value(column);
+      auto it = std::lower_bound(values.begin(), values.end(), x);
+      if ( it == values.end() || *it != x ) {
+        return false;
+      }
+      supports[column] = support(column, (size_t)(it - values.begin()));
+    }
+    for ( size_t word = 0; word < _words; word++ ) {
+      uint64_t tuples = ~(uint64_t)0;
+      for ( size_t column = 0; column < _columns.size() && tuples; column++ ) {
+        tuples &= supports[column][word];
+      }
+      if ( tuples ) {
+        return true;
+      }
+    }
+    return false;
+  };
+
+  inline bool contains(const std::vector<double>& tuple) const {
+    return contains( [&tuple](size_t column) { return tuple[column]; } );
+  };
+
+  /**
+   * @brief Returns true if the constraint is satisfied by the tuple given by value(column) for each column.
+   */
+  template<typename Values>
+  inline bool isSatisfied(const Values& value) const {
+    return contains(value) == ( type == Type::ALLOWED );
+  };
+
+  inline bool isSatisfied(const std::vector<double>& tuple) const {
+    return contains(tuple) == ( type == Type::ALLOWED );
+  };
+
+  /**
+   * @brief Tightens the bounds of the variables and returns false if no assignment within the bounds can satisfy the constraint.
+   *
+   * For allowed tuples, the tuples within the bounds of all variables are determined by intersecting the bitsets
+   * of the supports and each bound is moved to the closest value still having a support. For forbidden tuples,
+   * the bounds of an integer variable are moved only if all other variables are fixed.
+   *
+   * @param bounds The bounds of the variables in the order of the columns.
+   */
+  inline bool propagate(std::vector<Interval>& bounds) const {
+    if ( bounds.size() != _columns.size() ) {
+      throw std::invalid_argument("CP: number of bounds does not match arity of table");
+    }
+    return type == Type::ALLOWED ? propagateAllowed(bounds) : propagateForbidden(bounds);
+  };
+
+  inline std::string stringify() const {
+    std::string result = "(";
+    for ( const Variable& variable : variables ) {
+      result += " " + variable.name + ",";
+    }
+    result.back() = ' ';
+    result += std::string(") ") + ( type == Type::ALLOWED ? "∈" : "∉" ) + " {";
+    for ( size_t row = 0; row < _size; row++ ) {
+      result += " (";
+      for ( size_t column = 0; column < _columns.size(); column++ ) {
+        result += " " + std::format("{:.2f}", value(row, column)) + ",";
+      }
+      result.back() = ' ';
+      result += "),";
+    }
+    if ( _size ) {
+      result.back() = ' ';
+    }
+    result += "}";
+    return result;
+  };
+
+private:
+  struct Column {
+    std::vector<double> values; ///< Sorted distinct values
+    std::vector<uint64_t> supports; ///< Bitset of the tuples supporting each value
+  };
+  size_t _size;
+  size_t _words;
+  std::vector<Column> _columns;
+
+  inline const uint64_t* support(size_t column, size_t position) const {
+    return &_columns[column].supports[position * _words];
+  };
+
+  /**
+   * @brief Returns the range of positions of the column values within the bounds.
+   */
+  inline std::pair<size_t, size_t> range(size_t column, const Interval& bounds) const {
+    auto& values = _columns[column].values;
+    return {
+      (size_t)( std::lower_bound(values.begin(), values.end(), bounds.lowerBound) - values.begin() ),
+      (size_t)( std::upper_bound(values.begin(), values.end(), bounds.upperBound) - values.begin() )
+    };
+  };
+
+  inline bool intersects(const uint64_t* lhs, const std::vector<uint64_t>& rhs) const {
+    for ( size_t word = 0; word < _words; word++ ) {
+      if ( lhs[word] & rhs[word] ) {
+        return true;
+      }
+    }
+    return false;
+  };
+
+  inline bool propagateAllowed(std::vector<Interval>& bounds) const {
+    std::vector<uint64_t> current(_words, ~(uint64_t)0);
+    std::vector<uint64_t> mask(_words);
+    for ( size_t column = 0; column < _columns.size(); column++ ) {
+      auto [first, last] = range(column, bounds[column]);
+      std::fill(mask.begin(), mask.end(), 0);
+      for ( size_t position = first; position < last; position++ ) {
+        for ( size_t word = 0; word < _words; word++ ) {
+          mask[word] |= support(column, position)[word];
+        }
+      }
+      for ( size_t word = 0; word < _words; word++ ) {
+        current[word] &= mask[word];
+      }
+    }
+    if ( !intersects(current.data(), current) ) {
+      return false;
+    }
+    // values without support in the current tuples are removed from the bounds
+    for ( size_t column = 0; column < _columns.size(); column++ ) {
+      auto [first, last] = range(column, bounds[column]);
+      while ( !intersects(support(column, first), current) ) {
+        first++;
+      }
+      while ( !intersects(support(column, last - 1), current) ) {
+        last--;
+      }
+      bounds[column] = { _columns[column].values[first], _columns[column].values[last - 1] };
+    }
+    return true;
+  };
+
+  inline bool propagateForbidden(std::vector<Interval>& bounds) const {
+    std::optional<size_t> unfixed;
+    std::vector<uint64_t> current(_words, ~(uint64_t)0);
+    for ( size_t column = 0; column < _columns.size(); column++ ) {
+      if ( bounds[column].lowerBound != bounds[column].upperBound ) {
+        if ( unfixed ) {
+          return true;
+        }
+        unfixed = column;
+        continue;
+      }
+      auto [first, last] = range(column, bounds[column]);
+      if ( first == last ) {
+        return true;
+      }
+      for ( size_t word = 0; word < _words; word++ ) {
+        current[word] &= support(column, first)[word];
+      }
+    }
+    if ( !unfixed ) {
+      return !intersects(current.data(), current);
+    }
+    if ( variables[unfixed.value()].type == Variable::Type::REAL ) {
+      return true;
+    }
+    // move the bounds of the only unfixed variable away from forbidden values, each step passes a value of the column
+    auto& values = _columns[unfixed.value()].values;
+    auto& [lowerBound, upperBound] = bounds[unfixed.value()];
+    auto [first, last] = range(unfixed.value(), bounds[unfixed.value()]);
+    auto isForbidden = [&](size_t position) { return intersects(support(unfixed.value(), position), current); };
+    while ( first < last && values[first] == lowerBound && isForbidden(first) ) {
+      lowerBound = nextInteger(lowerBound, std::numeric_limits<double>::max());
+      first++;
+    }
+    while ( first < last && values[last - 1] == upperBound && isForbidden(last - 1) ) {
+      upperBound = nextInteger(upperBound, std::numeric_limits<double>::lowest());
+      last--;
+    }
+    return lowerBound <= upperBound;
+  };
+
+  /**
+   * @brief Returns the closest integer after the integer value in the direction, which is the adjacent double for magnitudes of at least 2^53.
+   */
+  inline static double nextInteger(double value, double direction) {
+    double next = ( direction > value ) ? value + 1 : value - 1;
+    return ( next != value ) ? next : std::nextafter(value, direction);
+  };
+};
+
+/*******************************************
+ * Linear constraints
+ ******************************************/
+
+/**
+ * @brief Represents a constraint `coefficients[0] * variables[0] + ... + coefficients[n-1] * variables[n-1] <op> rhs` with op being `<=`, `>=`, or `==`.
+ */
+struct LinearConstraint {
+  inline LinearConstraint(std::vector<double> coefficients, reference_vector<const Variable> variables, Expression::Operator _operator, double rhs)
+    : coefficients(std::move(coefficients))
+    , variables(std::move(variables))
+    , _operator(_operator)
+    , rhs(rhs)
+  {
+    if ( this->coefficients.size() != this->variables.size() ) {
+      throw std::invalid_argument("CP: linear constraint requires one coefficient per variable");
+    }
+    if ( _operator != Expression::Operator::less_or_equal && _operator != Expression::Operator::greater_or_equal && _operator != Expression::Operator::equal ) {
+      throw std::invalid_argument("CP: linear constraint requires <=, >=, or ==");
+    }
+  };
+
+  std::vector<double> coefficients;
+  reference_vector<const Variable> variables;
+  Expression::Operator _operator;
+  double rhs;
+
+  /**
+   * @brief Returns the violation of the constraint for the given value of the left-hand side.
+   */
+  inline double violation(double lhs) const {
+    switch ( _operator ) {
+      case Expression::Operator::less_or_equal: return std::max(0.0, lhs - rhs);
+      case Expression::Operator::greater_or_equal: return std::max(0.0, rhs - lhs);
+      default: return std::abs(lhs - rhs);
+    }
+  };
+
+  inline std::string stringify() const {
+    std::string result;
+    for ( size_t i = 0; i < variables.size(); i++ ) {
+      result += ( i ? " + " : "" ) + std::format("{:.2f}", coefficients[i]) + " * " + variables[i].name;
+    }
+    if ( variables.empty() ) {
+      result += std::format("{:.2f}", 0.0);
+    }
+    std::string op = _operator == Expression::Operator::less_or_equal ? "<=" : ( _operator == Expression::Operator::greater_or_equal ? ">=" : "==" );
+    return result + " " + op + " " + std::format("{:.2f}", rhs);
+  };
+};
+
+/**
+ * @brief Represents a weighted sum of variables used to create linear constraints.
+ */
+struct LinearSum {
+  std::vector<double> coefficients;
+  reference_vector<const Variable> variables;
+
+  inline LinearConstraint operator<=(double rhs) const { return LinearConstraint(coefficients, variables, Expression::Operator::less_or_equal, rhs); };
+  inline LinearConstraint operator>=(double rhs) const { return LinearConstraint(coefficients, variables, Expression::Operator::greater_or_equal, rhs); };
+  inline LinearConstraint operator==(double rhs) const { return LinearConstraint(coefficients, variables, Expression::Operator::equal, rhs); };
+};
+
+/**
+ * @brief Creates the weighted sum of the given variables.
+ */
+inline LinearSum linear(std::vector<double> coefficients, const std::vector<std::reference_wrapper<const Variable>>& variables) {
+  if ( coefficients.size() != variables.size() ) {
+    throw std::invalid_argument("CP: linear sum requires one coefficient per variable");
+  }
+  LinearSum sum{ std::move(coefficients), {} };
+  for ( auto& variable : variables ) {
+    sum.variables.push_back(variable);
+  }
+  return sum;
+};
+
+/**
+ * @brief Creates the number of the given boolean variables which are true.
+ */
+inline LinearSum count(const std::vector<std::reference_wrapper<const Variable>>& variables) {
+  return linear( std::vector<double>(variables.size(), 1.0), variables );
+};
+
+/**
+ * @brief Creates a constraint requiring that at most k of the given boolean variables are true.
+ */
+inline LinearConstraint atmost(size_t k, const std::vector<std::reference_wrapper<const Variable>>& variables) {
+  return count(variables) <= (double)k;
+};
+
+/**
+ * @brief Creates a constraint requiring that at least k of the given boolean variables are true.
+ */
+inline LinearConstraint atleast(size_t k, const std::vector<std::reference_wrapper<const Variable>>& variables) {
+  return count(variables) >= (double)k;
+};
+
 /*******************************************
  * Custom operators
  ******************************************/
@@ -727,6 +1111,92 @@ inline Expression n_ary_if(Cases cases, Expression elseExpression) {
   return Expression(Expression::Operator::custom,std::move(operands));
 };
 
+using Breakpoints = std::vector< std::pair<double, double> >;
+
+inline Expression breakpointOperator(const std::string& name, Expression expression, const Breakpoints& breakpoints) {
+  if (breakpoints.empty()) {
+    throw std::invalid_argument("CP: " + name + " requires at least one breakpoint");
+  }
+  for ( size_t i = 1; i < breakpoints.size(); i++ ) {
+    if ( breakpoints[i-1].first >= breakpoints[i].first ) {
+      throw std::invalid_argument("CP: " + name + " requires strictly increasing breakpoints");
+    }
+  }
+
+  std::vector< Operand > operands;
+  operands.reserve(2 * breakpoints.size() + 2);
+  operands.push_back( Expression::getCustomIndex(name) );
+  operands.push_back(std::move(expression));
+  for ( auto& [x,y] : breakpoints ) {
+    operands.push_back(x);
+    operands.push_back(y);
+  }
+  return Expression(Expression::Operator::custom,std::move(operands));
+}
+
+/**
+ * @brief Creates a piecewise-linear function of an expression given by breakpoints (x_1,y_1), ..., (x_n,y_n) with x_1 < ... < x_n.
+ *
+ * Between two breakpoints the value is linearly interpolated, below x_1 the value is y_1, and above x_n the value is y_n.
+ */
+inline Expression piecewise_linear(Expression expression, const Breakpoints& breakpoints) {
+  return breakpointOperator("piecewise_linear", std::move(expression), breakpoints);
+};
+
+/**
+ * @brief Creates a step function of an expression given by breakpoints (x_1,y_1), ..., (x_n,y_n) with x_1 < ... < x_n.
+ *
+ * The value is y_k for x_k <= x < x_{k+1}, y_n for x_n <= x, and y_1 for x < x_1.
+ */
+inline Expression step(Expression expression, const Breakpoints& breakpoints) {
+  return breakpointOperator("step", std::move(expression), breakpoints);
+};
+
+/**
+ * @brief Returns the argument and breakpoints of a piecewise-linear or step function, or std::nullopt if the expression is neither.
+ */
+inline std::optional<std::pair<Operand, Breakpoints>> isBreakpointOperator( const Expression& expression ) {
+  if (
+    expression._operator != Expression::Operator::custom ||
+    (
+      Expression::customOperators[std::get<size_t>(expression.operands.front())] != "piecewise_linear" &&
+      Expression::customOperators[std::get<size_t>(expression.operands.front())] != "step"
+    )
+  ) {
+    return std::nullopt;
+  }
+  Breakpoints breakpoints;
+  breakpoints.reserve(expression.operands.size() / 2 - 1);
+  for ( size_t i = 2; i + 1 < expression.operands.size(); i += 2 ) {
+    breakpoints.emplace_back( std::get<double>(expression.operands[i]), std::get<double>(expression.operands[i+1]) );
+  }
+  return std::make_pair(expression.operands[1], std::move(breakpoints));
+};
+
+/*******************************************
+ * Soft constraints
+ ******************************************/
+
+/**
+ * @brief Represents a constraint which may be violated at a penalty of its weight times its violation.
+ *
+ * Penalties of different priorities are compared lexicographically, i.e., any reduction of the penalty of a higher
+ * priority is preferred over any reduction of the penalty of a lower priority, regardless of the weights.
+ */
+struct SoftConstraint {
+  std::variant<Expression, LinearConstraint> constraint;
+  double weight;
+  size_t priority;
+
+  inline std::string stringify() const {
+    std::string result = std::format("[ weight {:.2f}, priority {} ] ", weight, priority);
+    if ( std::holds_alternative<Expression>(constraint) ) {
+      return result + std::get<Expression>(constraint).stringify();
+    }
+    return result + std::get<LinearConstraint>(constraint).stringify();
+  };
+};
+
 /*******************************************
  * Model
  ******************************************/
@@ -737,15 +1207,88 @@ inline Expression n_ary_if(Cases cases, Expression elseExpression) {
 class Model {
 public:
   enum class ObjectiveSense { FEASIBLE, MINIMIZE, MAXIMIZE };
-  inline Model(ObjectiveSense objectiveSense = ObjectiveSense::FEASIBLE ) : objectiveSense(objectiveSense) {};
-  inline ObjectiveSense getObjectiveSense() const { return objectiveSense; };
-  inline const Expression& getObjective() const { return objective; };
+  /**
+   * @brief Represents an objective given by an expression to be minimized or maximized.
+   */
+  struct Objective {
+    ObjectiveSense sense;
+    Expression expression;
+  };
+  /**
+   * @brief Represents the size and structure of a model as computed by statistics().
+   */
+  struct Statistics {
+    std::array<size_t,3> variables = {}; ///< Number of variables by type including indexed and sequence variables
+    size_t deducedVariables = 0; ///< Number of variables deduced from an expression
+    std::map<std::string,size_t> constraints; ///< Number of constraints by top-level operator
+    size_t linearConstraints = 0;
+    size_t softConstraints = 0;
+    size_t tables = 0;
+    size_t sequences = 0;
+    size_t objectives = 0;
+    std::map<std::string,size_t> customOperators; ///< Number of nodes by name of custom operator
+    size_t nodes = 0; ///< Number of expression nodes in constraints, objectives, and deduced expressions
+    size_t maxDepth = 0; ///< Maximal number of nested expression nodes
+    size_t distinctNodes = 0; ///< Number of structurally distinct subtrees
+    size_t duplicatedNodes = 0; ///< Number of nodes rooting a subtree which is structurally equal to another subtree
+    size_t sharedReferences = 0; ///< Number of references to deduced variables, each reusing a subtree without copying it
+    size_t nameBytes = 0; ///< Bytes used by names of variables
+    size_t operandBytes = 0; ///< Bytes used by operands of all expression nodes
+    size_t deducedBytes = 0; ///< Bytes used by expressions of deduced variables including their operands
+
+    inline std::string json() const {
+      auto object = [](const std::map<std::string,size_t>& counts) {
+        std::string result = "{";
+        for ( auto& [name, count] : counts ) {
+          result += std::format("{}\"{}\": {}", result.size() > 1 ? ", " : " ", name, count);
+        }
+        return result + ( counts.empty() ? "}" : " }" );
+      };
+      return std::format(
+        "{{ \"variables\": {{ \"boolean\": {}, \"integer\": {}, \"real\": {}, \"deduced\": {} }}, "
+        "\"constraints\": {}, \"linearConstraints\": {}, \"softConstraints\": {}, \"tables\": {}, \"sequences\": {}, \"objectives\": {}, "
+        "\"customOperators\": {}, \"nodes\": {}, \"maxDepth\": {}, \"distinctNodes\": {}, \"duplicatedNodes\": {}, \"sharedReferences\": {}, "
+        "\"nameBytes\": {}, \"operandBytes\": {}, \"deducedBytes\": {} }}",
+        variables[0], variables[1], variables[2], deducedVariables,
+        object(constraints), linearConstraints, softConstraints, tables, sequences, objectives,
+        object(customOperators), nodes, maxDepth, distinctNodes, duplicatedNodes, sharedReferences,
+        nameBytes, operandBytes, deducedBytes
+      );
+    }
+  };
+  inline Model(ObjectiveSense objectiveSense = ObjectiveSense::FEASIBLE ) : objectives({ Objective{ objectiveSense, Expression() } }) {};
+  inline ObjectiveSense getObjectiveSense() const { return objectives.front().sense; };
+  inline const Expression& getObjective() const { return objectives.front().expression; };
+  /**
+   * @brief Returns all objectives in lexicographic order, the first objective is the one given by getObjectiveSense() and getObjective().
+   */
+  inline const std::list< Objective >& getObjectives() const { return objectives; };
   inline const std::list< Variable >& getVariables() const { return variables; };
   inline const std::list< IndexedVariables >& getIndexedVariables() const { return indexedVariables; };
   inline const std::list< Expression >& getConstraints() const { return constraints; };
   inline const std::list< Sequence >& getSequences() const { return sequences; };
+  inline const std::list< Table >& getTables() const { return tables; };
+  inline const std::list< LinearConstraint >& getLinearConstraints() const { return linearConstraints; };
+  inline const std::list< SoftConstraint >& getSoftConstraints() const { return softConstraints; };
 
-  inline const Expression& setObjective(Expression objective) { this->objective = std::move(objective); return this->objective; };
+  inline const Expression& setObjective(Expression objective) { objectives.front().expression = std::move(objective); return objectives.front().expression; };
+
+  /**
+   * @brief Adds an objective which is lexicographically less important than all previously added objectives.
+   *
+   * If the model has no objective, i.e. the objective sense is FEASIBLE, the added objective becomes the first objective.
+   */
+  inline const Expression& addObjective(ObjectiveSense sense, Expression objective) {
+    if ( sense == ObjectiveSense::FEASIBLE ) {
+      throw std::invalid_argument("CP: objective must be minimized or maximized");
+    }
+    if ( objectives.front().sense == ObjectiveSense::FEASIBLE ) {
+      objectives.front() = { sense, std::move(objective) };
+      return objectives.front().expression;
+    }
+    objectives.push_back( { sense, std::move(objective) } );
+    return objectives.back().expression;
+  };
 
   inline const Variable& addVariable( Variable::Type type, std::string name, double lowerBound, double upperBound ) {
     variables.emplace_back(type, std::move(name), lowerBound, upperBound);
@@ -782,11 +1325,310 @@ public:
     return variables.back();
   }
 
+  inline const Table& addTable( std::vector<std::reference_wrapper<const Variable>> variables, const std::vector< std::vector<double> >& tuples, Table::Type type = Table::Type::ALLOWED ) {
+    tables.emplace_back(std::move(variables), tuples, type);
+    return tables.back();
+  }
+
   inline const Expression& addConstraint( Expression constraint) {
     constraints.push_back( std::move(constraint) );
     return constraints.back();
   };
 
+  inline const LinearConstraint& addConstraint( LinearConstraint constraint) {
+    linearConstraints.push_back( std::move(constraint) );
+    return linearConstraints.back();
+  };
+
+  /**
+   * @brief Adds a soft constraint which may be violated at a penalty of weight times violation.
+   *
+   * @param weight The weight of the violation, must be non-negative.
+   * @param priority The priority of the constraint, penalties of higher priorities are minimized first.
+   */
+  inline const SoftConstraint& addConstraint( Expression constraint, double weight, size_t priority = 0) {
+    if ( weight < 0.0 ) {
+      throw std::invalid_argument("CP: soft constraint requires non-negative weight");
+    }
+    softConstraints.push_back( { std::move(constraint), weight, priority } );
+    return softConstraints.back();
+  };
+
+  inline const SoftConstraint& addConstraint( LinearConstraint constraint, double weight, size_t priority = 0) {
+    if ( weight < 0.0 ) {
+      throw std::invalid_argument("CP: soft constraint requires non-negative weight");
+    }
+    softConstraints.push_back( { std::move(constraint), weight, priority } );
+    return softConstraints.back();
+  };
+
+  /**
+   * @brief Adds variables and constraints representing a piecewise-linear or step function by linear constraints and returns the linear expression of its value.
+   *
+   * A piecewise-linear function is represented by the incremental formulation with continuous variables `name_delta[k]` for each segment
+   * and binary variables `name_z[k]` enforcing that segments are filled in order. If the argument may be below the first or above the last
+   * breakpoint, segments with constant value are added for which the respective bound of the argument must be finite.
+   * A step function is represented by binary variables `name_z[k]` which are true if and only if the argument is at least x_{k+1}.
+   *
+   * @param name The name prefix of the added variables.
+   * @param function The piecewise-linear or step function.
+   * @param lowerBound A lower bound of the argument.
+   * @param upperBound An upper bound of the argument.
+   */
+  inline Expression addLinearization( std::string name, const Expression& function, double lowerBound, double upperBound ) {
+    auto decomposition = isBreakpointOperator(function);
+    if ( !decomposition ) {
+      throw std::invalid_argument("CP: linearization requires piecewise-linear or step function");
+    }
+    auto& [operand, breakpoints] = decomposition.value();
+    Expression argument = std::holds_alternative<Expression>(operand) ? std::get<Expression>(operand) :
+      std::holds_alternative<double>(operand) ? Expression(std::get<double>(operand)) :
+      Expression(std::get<std::reference_wrapper<const Variable>>(operand).get());
+
+    auto& z = addIndexedVariables(Variable::Type::BOOLEAN, name + "_z");
+    if ( Expression::customOperators[std::get<size_t>(function.operands.front())] == "step" ) {
+      std::optional<Expression> value;
+      for ( size_t k = 1; k < breakpoints.size(); k++ ) {
+        z.emplace_back(0,1);
+        addConstraint( z[k-1].implies( argument >= breakpoints[k].first ) );
+        addConstraint( (!z[k-1]).implies( argument < breakpoints[k].first ) );
+        if ( double change = breakpoints[k].second - breakpoints[k-1].second; change != 0.0 ) {
+          value = value ? value.value() + change * z[k-1] : breakpoints.front().second + change * z[k-1];
+        }
+      }
+      return value.value_or( breakpoints.front().second );
+    }
+
+    // add constant segments if argument may be outside of the breakpoints
+    if ( lowerBound < breakpoints.front().first ) {
+      if ( lowerBound == std::numeric_limits<double>::lowest() ) {
+        throw std::invalid_argument("CP: linearization requires finite lower bound of argument");
+      }
+      breakpoints.insert( breakpoints.begin(), { lowerBound, breakpoints.front().second } );
+    }
+    if ( upperBound > breakpoints.back().first ) {
+      if ( upperBound == std::numeric_limits<double>::max() ) {
+        throw std::invalid_argument("CP: linearization requires finite upper bound of argument");
+      }
+      breakpoints.push_back( { upperBound, breakpoints.back().second } );
+    }
+    if ( breakpoints.size() == 1 ) {
+      addConstraint( argument == breakpoints.front().first );
+      return breakpoints.front().second;
+    }
+
+    auto& delta = addIndexedVariables(Variable::Type::REAL, name + "_delta");
+    std::optional<Expression> position;
+    std::optional<Expression> value;
+    for ( size_t k = 1; k < breakpoints.size(); k++ ) {
+      delta.emplace_back(0,1);
+      double length = breakpoints[k].first - breakpoints[k-1].first;
+      position = position ? position.value() + length * delta[k-1] : breakpoints.front().first + length * delta[k-1];
+      if ( double change = breakpoints[k].second - breakpoints[k-1].second; change != 0.0 ) {
+        value = value ? value.value() + change * delta[k-1] : breakpoints.front().second + change * delta[k-1];
+      }
+      if ( k > 1 ) {
+        z.emplace_back(0,1);
+        addConstraint( delta[k-1] <= z[k-2] );
+        addConstraint( z[k-2] <= delta[k-2] );
+      }
+    }
+    addConstraint( argument == position.value() );
+    return value.value_or( breakpoints.front().second );
+  }
+
+  /**
+   * @brief Adds a linearization of a piecewise-linear or step function with the bounds of the argument taken from the argument.
+   *
+   * The bounds are those of the variable or the value of the constant given as argument. A piecewise-linear function of
+   * any other expression requires explicit bounds of the argument.
+   */
+  inline Expression addLinearization( std::string name, const Expression& function ) {
+    auto decomposition = isBreakpointOperator(function);
+    if ( !decomposition ) {
+      throw std::invalid_argument("CP: linearization requires piecewise-linear or step function");
+    }
+    const Operand* argument = &decomposition.value().first;
+    if ( std::holds_alternative<Expression>(*argument) && std::get<Expression>(*argument)._operator == Expression::Operator::none ) {
+      argument = &std::get<Expression>(*argument).operands.front();
+    }
+    auto& operand = *argument;
+    if ( std::holds_alternative<std::reference_wrapper<const Variable>>(operand) ) {
+      auto& variable = std::get<std::reference_wrapper<const Variable>>(operand).get();
+      return addLinearization( std::move(name), function, variable.lowerBound, variable.upperBound );
+    }
+    if ( std::holds_alternative<double>(operand) ) {
+      return addLinearization( std::move(name), function, std::get<double>(operand), std::get<double>(operand) );
+    }
+    if ( Expression::customOperators[std::get<size_t>(function.operands.front())] != "step" ) {
+      throw std::invalid_argument("CP: linearization of piecewise-linear function of an expression requires bounds of argument");
+    }
+    return addLinearization( std::move(name), function, std::numeric_limits<double>::lowest(), std::numeric_limits<double>::max() );
+  }
+
+  /**
+   * @brief Returns the size and structure of the model.
+   *
+   * All expressions are traversed once without recursion. Structurally equal subtrees are detected by hash-consing,
+   * i.e. each node is identified by its operator and the identifiers of its operands, which takes expected linear time.
+   */
+  inline Statistics statistics() const {
+    CP_TRACE_SCOPE("Model::statistics");
+    Statistics result;
+    // bytes of a string including its heap buffer, if any
+    auto bytes = [](const std::string& string) {
+      auto address = reinterpret_cast<const char*>(&string);
+      bool local = string.data() >= address && string.data() < address + sizeof(std::string);
+      return sizeof(std::string) + ( local ? 0 : string.capacity() + 1 );
+    };
+    std::vector<const Expression*> deduced;
+    auto addVariable = [&](const Variable& variable) {
+      result.variables[(size_t)variable.type]++;
+      result.nameBytes += bytes(variable.name);
+      if ( variable.deducedFrom ) {
+        result.deducedVariables++;
+        result.deducedBytes += sizeof(Expression);
+        deduced.push_back(variable.deducedFrom.get());
+      }
+    };
+    for ( auto& variable : variables ) {
+      addVariable(variable);
+    }
+    for ( auto& indexed : indexedVariables ) {
+      result.nameBytes += bytes(indexed.name);
+      for ( auto& variable : indexed ) {
+        addVariable(variable);
+      }
+    }
+    for ( auto& sequence : sequences ) {
+      for ( const Variable& variable : sequence.variables ) {
+        addVariable(variable);
+      }
+    }
+    result.sequences = sequences.size();
+    result.tables = tables.size();
+    result.linearConstraints = linearConstraints.size();
+    result.softConstraints = softConstraints.size();
+
+    constexpr std::array<const char*,16> operatorNames = {
+      "none", "negate", "logical_not", "logical_and", "logical_or", "add", "subtract", "multiply", "divide", "custom",
+      "less_than", "less_or_equal", "greater_than", "greater_or_equal", "equal", "not_equal"
+    };
+    for ( auto& constraint : constraints ) {
+      result.constraints[operatorNames[(size_t)constraint._operator]]++;
+    }
+
+    // identifiers of structurally distinct subtrees
+    struct Hash {
+      size_t operator()(const std::vector<uint64_t>& key) const {
+        uint64_t hash = 0xcbf29ce484222325;
+        for ( auto word : key ) {
+          hash = ( hash ^ word ) * 0x100000001b3;
+        }
+        return (size_t)hash;
+      }
+    };
+    std::unordered_map<std::vector<uint64_t>, size_t, Hash> identifiers;
+    std::vector<size_t> childIdentifiers;
+    std::vector<uint64_t> key;
+    std::vector<size_t> customUsage;
+
+    struct Frame {
+      const Expression* expression;
+      size_t depth;
+      bool expanded;
+    };
+    std::vector<Frame> stack;
+    auto traverse = [&](const Expression& root, bool isDeduced) {
+      stack.push_back({ &root, 1, false });
+      while ( !stack.empty() ) {
+        auto& frame = stack.back();
+        auto& expression = *frame.expression;
+        if ( !frame.expanded ) {
+          frame.expanded = true;
+          size_t depth = frame.depth;
+          result.nodes++;
+          result.maxDepth = std::max(result.maxDepth, depth);
+          size_t operandBytes = expression.operands.capacity() * sizeof(Operand);
+          result.operandBytes += operandBytes;
+          if ( isDeduced ) {
+            result.deducedBytes += operandBytes;
+          }
+          if ( expression._operator == Expression::Operator::custom ) {
+            auto index = std::get<size_t>(expression.operands.front());
+            if ( index >= customUsage.size() ) {
+              customUsage.resize(index + 1, 0);
+            }
+            customUsage[index]++;
+          }
+          // push children in reverse order so that their identifiers are completed in order
+          for ( auto it = expression.operands.rbegin(); it != expression.operands.rend(); it++ ) {
+            if ( std::holds_alternative<Expression>(*it) ) {
+              stack.push_back({ &std::get<Expression>(*it), depth + 1, false });
+            }
+            else if ( std::holds_alternative<std::reference_wrapper<const Variable>>(*it) && std::get<std::reference_wrapper<const Variable>>(*it).get().deducedFrom ) {
+              result.sharedReferences++;
+            }
+          }
+          continue;
+        }
+        // all children are completed, their identifiers are on top of childIdentifiers
+        size_t children = (size_t)std::ranges::count_if(expression.operands, [](const Operand& operand) { return std::holds_alternative<Expression>(operand); });
+        size_t child = childIdentifiers.size() - children;
+        key.clear();
+        key.push_back((uint64_t)expression._operator);
+        for ( auto& operand : expression.operands ) {
+          key.push_back(operand.index());
+          if ( std::holds_alternative<size_t>(operand) ) {
+            key.push_back(std::get<size_t>(operand));
+          }
+          else if ( std::holds_alternative<double>(operand) ) {
+            key.push_back(std::bit_cast<uint64_t>(std::get<double>(operand)));
+          }
+          else if ( std::holds_alternative<std::reference_wrapper<const Variable>>(operand) ) {
+            key.push_back((uint64_t)reinterpret_cast<uintptr_t>(&std::get<std::reference_wrapper<const Variable>>(operand).get()));
+          }
+          else {
+            key.push_back(childIdentifiers[child++]);
+          }
+        }
+        childIdentifiers.resize(childIdentifiers.size() - children);
+        auto [it, inserted] = identifiers.try_emplace(key, identifiers.size());
+        if ( !inserted ) {
+          result.duplicatedNodes++;
+        }
+        childIdentifiers.push_back(it->second);
+        stack.pop_back();
+      }
+      childIdentifiers.clear();
+    };
+
+    for ( auto& constraint : constraints ) {
+      traverse(constraint, false);
+    }
+    for ( auto& constraint : softConstraints ) {
+      if ( std::holds_alternative<Expression>(constraint.constraint) ) {
+        traverse(std::get<Expression>(constraint.constraint), false);
+      }
+    }
+    for ( auto& objective : objectives ) {
+      if ( objective.sense != ObjectiveSense::FEASIBLE ) {
+        result.objectives++;
+        traverse(objective.expression, false);
+      }
+    }
+    for ( auto expression : deduced ) {
+      traverse(*expression, true);
+    }
+    result.distinctNodes = identifiers.size();
+    for ( size_t index = 0; index < customUsage.size(); index++ ) {
+      if ( customUsage[index] ) {
+        result.customOperators[Expression::customOperators[index]] = customUsage[index];
+      }
+    }
+    return result;
+  }
+
   inline std::string stringify() const {
     std::string result;
     result +=  "Sequences:\n";
@@ -805,13 +1647,33 @@ public:
     for (const auto& constraint : getConstraints()) {
       result += constraint.stringify() + "\n";
     }
+    if ( !getLinearConstraints().empty() ) {
+      result +=  "Linear constraints:\n";
+      for (const auto& constraint : getLinearConstraints()) {
+        result += constraint.stringify() + "\n";
+      }
+    }
+    if ( !getSoftConstraints().empty() ) {
+      result +=  "Soft constraints:\n";
+      for (const auto& constraint : getSoftConstraints()) {
+        result += constraint.stringify() + "\n";
+      }
+    }
+    if ( !getTables().empty() ) {
+      result +=  "Tables:\n";
+      for (const auto& table : getTables()) {
+        result += table.stringify() + "\n";
+      }
+    }
     return result;
   }
 
 private:  
-  ObjectiveSense objectiveSense;
-  Expression objective;
+  std::list< Objective > objectives;
   std::list< Sequence > sequences;
+  std::list< Table > tables;
+  std::list< LinearConstraint > linearConstraints;
+  std::list< SoftConstraint > softConstraints;
   std::list< Variable > variables;
   std::list< IndexedVariables > indexedVariables;
   std::list< Expression > constraints;
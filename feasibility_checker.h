@@ -0,0 +1,330 @@
+ /**
+ ******************************************************************************
+ *
+ *  Feasibility checking of assignments with per-constraint profiling
+ *
+ ******************************************************************************
+ */
+
+#pragma once
+
+#include <chrono>
+#include <algorithm>
+#include <numeric>
+#include <variant>
+#include <optional>
+#include <limits>
+#include <stdexcept>
+
+#include "cp.h"
+#include "tape.h"
+#include "thread_pool.h"
+
+namespace CP {
+
+/*******************************************
+ * FeasibilityChecker
+ ******************************************/
+
+/**
+ * @brief Checks whether assignments of the inputs of a model satisfy all hard constraints.
+ *
+ * The constraints are the expression constraints, tables, and linear constraints of the model in this order. Each
+ * constraint is evaluated lazily on a tape, so that only the nodes required by the evaluated constraints are computed.
+ *
+ * Feasibility checks stop at the first violated constraint. As most infeasible assignments are rejected by few constraints,
+ * the order in which constraints are checked can be adapted to the observed rejections, either by moving a rejecting constraint
+ * to the front or by ordering constraints by decreasing rejection rate per cost, where the rejections are exponentially decayed
+ * and the cost of a constraint is the number of tape nodes it depends on.
+ *
+ * All violations of an assignment can be determined in parallel. Nodes required by more than one constraint, e.g. those of
+ * deduced variables, are computed once up front. Afterwards the constraints are partitioned into contiguous chunks with
+ * balanced numbers of the nodes required only by them, and the chunks are evaluated by the threads of a pool.
+ *
+ * In profiling mode the number of evaluations, the cumulative evaluation time, the number of violations, and the number
+ * of evaluations skipping arguments of conjunctions, disjunctions, or conditionals are recorded for each constraint.
+ */
+class FeasibilityChecker {
+public:
+  /**
+   * @brief Represents the observations made for a constraint in profiling mode.
+   */
+  struct Profile {
+    size_t evaluations = 0;
+    size_t violations = 0;
+    size_t shortCircuits = 0; ///< Number of evaluations in which arguments were skipped
+    double seconds = 0.0;
+  };
+
+  enum class Ordering { STATIC, MOVE_TO_FRONT, REJECTION_RATE };
+
+  inline FeasibilityChecker(const Model& model) : tape(model) {
+    size_t first = model.getObjectives().size();
+    for ( auto& constraint : model.getConstraints() ) {
+      constraints.push_back(&constraint);
+    }
+    for ( auto& table : model.getTables() ) {
+      constraints.push_back(&table);
+    }
+    for ( auto& constraint : model.getLinearConstraints() ) {
+      constraints.push_back(&constraint);
+    }
+    outputs.resize(constraints.size());
+    std::iota(outputs.begin(), outputs.end(), first);
+    profiles.resize(constraints.size());
+    order.resize(constraints.size());
+    std::iota(order.begin(), order.end(), 0);
+    activities.resize(constraints.size(), 0.0);
+
+    // the cost of a constraint is the size of the cone of its output
+    auto& nodes = tape.getNodes();
+    auto& arguments = tape.getArguments();
+    std::vector<size_t> marks(nodes.size(), constraints.size());
+    std::vector<size_t> stack;
+    costs.resize(constraints.size(), 0.0);
+    // owner of each node required by exactly one constraint
+    constexpr size_t none = std::numeric_limits<size_t>::max();
+    constexpr size_t several = none - 1;
+    std::vector<size_t> owners(nodes.size(), none);
+    for ( size_t constraint = 0; constraint < constraints.size(); constraint++ ) {
+      stack.push_back(tape.getOutputs()[outputs[constraint]]);
+      marks[stack.back()] = constraint;
+      while ( !stack.empty() ) {
+        size_t index = stack.back();
+        auto& node = nodes[index];
+        stack.pop_back();
+        costs[constraint]++;
+        owners[index] = ( owners[index] == none ) ? constraint : several;
+        for ( size_t i = node.first; i < node.first + node.count; i++ ) {
+          if ( marks[arguments[i]] != constraint ) {
+            marks[arguments[i]] = constraint;
+            stack.push_back(arguments[i]);
+          }
+        }
+      }
+    }
+    // nodes owned by each constraint in increasing order
+    ownedStart.assign(constraints.size() + 1, 0);
+    for ( size_t index = 0; index < nodes.size(); index++ ) {
+      if ( owners[index] == several ) {
+        sharedNodes.push_back(index);
+      }
+      else if ( owners[index] != none ) {
+        ownedStart[owners[index] + 1]++;
+      }
+    }
+    for ( size_t constraint = 0; constraint < constraints.size(); constraint++ ) {
+      ownedStart[constraint + 1] += ownedStart[constraint];
+    }
+    ownedNodes.resize(ownedStart.back());
+    std::vector<size_t> position(ownedStart.begin(), ownedStart.end() - 1);
+    for ( size_t index = 0; index < nodes.size(); index++ ) {
+      if ( owners[index] < several ) {
+        ownedNodes[position[owners[index]]++] = index;
+      }
+    }
+  }
+
+  inline size_t size() const { return constraints.size(); };
+  inline const Tape& getTape() const { return tape; };
+  /**
+   * @brief Returns the output of the tape providing the violation of a constraint.
+   */
+  inline size_t getOutput(size_t constraint) const { return outputs.at(constraint); };
+
+  /**
+   * @brief Returns the variables whose values must be provided in this order.
+   */
+  inline const std::vector<const Variable*>& getInputs() const { return tape.getInputs(); };
+
+  inline std::string stringify(size_t constraint) const {
+    return std::visit( [](auto pointer) { return pointer->stringify(); }, constraints.at(constraint) );
+  }
+
+  /**
+   * @brief Sets the strategy adapting the order in which constraints are checked, the current order is kept.
+   */
+  inline void setOrdering(Ordering strategy) { ordering = strategy; };
+  /**
+   * @brief Returns the constraints in the order in which they are checked.
+   */
+  inline const std::vector<size_t>& getOrder() const { return order; };
+  /**
+   * @brief Returns the number of tape nodes a constraint depends on.
+   */
+  inline double getCost(size_t constraint) const { return costs.at(constraint); };
+
+  inline void setProfiling(bool enabled) { profiling = enabled; };
+  inline const std::vector<Profile>& getProfiles() const { return profiles; };
+  inline void resetProfiles() { profiles.assign(constraints.size(), Profile()); };
+
+  /**
+   * @brief Sets the values of the inputs for subsequent calls of violation().
+   */
+  inline void setInputs(const std::vector<double>& values) { tape.setInputs(values); };
+
+  /**
+   * @brief Returns the violation of a constraint for the values given by setInputs(), which is zero if the constraint is satisfied.
+   */
+  inline double violation(size_t constraint) {
+    if ( !profiling ) {
+      return tape.evaluate(outputs[constraint]);
+    }
+    auto& profile = profiles[constraint];
+    size_t shortCircuits = tape.getShortCircuits();
+    auto start = std::chrono::steady_clock::now();
+    double result = tape.evaluate(outputs[constraint]);
+    profile.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    profile.evaluations++;
+    profile.violations += ( result > 0.0 );
+    profile.shortCircuits += ( tape.getShortCircuits() != shortCircuits );
+    return result;
+  }
+
+  /**
+   * @brief Checks the constraints in the current order and returns the first constraint violated by the values, or std::nullopt if all constraints are satisfied.
+   *
+   * The order is adapted according to the ordering strategy.
+   */
+  inline std::optional<size_t> findViolation(const std::vector<double>& values) {
+    setInputs(values);
+    for ( size_t position = 0; position < order.size(); position++ ) {
+      size_t constraint = order[position];
+      if ( violation(constraint) > 0.0 ) {
+        reject(position);
+        return constraint;
+      }
+    }
+    return std::nullopt;
+  }
+
+  /**
+   * @brief Returns true if the values satisfy all constraints.
+   */
+  inline bool isFeasible(const std::vector<double>& values) {
+    return !findViolation(values);
+  }
+
+  /**
+   * @brief Returns all constraints violated by the values in the order of the model together with their violations.
+   */
+  inline std::vector< std::pair<size_t, double> > violations(const std::vector<double>& values) {
+    setInputs(values);
+    std::vector< std::pair<size_t, double> > result;
+    for ( size_t constraint = 0; constraint < constraints.size(); constraint++ ) {
+      if ( double value = violation(constraint); value > 0.0 ) {
+        result.push_back({ constraint, value });
+      }
+    }
+    return result;
+  }
+
+  /**
+   * @brief Returns all constraints violated by the values in the order of the model together with their violations, using the threads of a pool.
+   *
+   * The order of the constraints, the profiles, and the short-circuit statistics of the tape are not changed.
+   */
+  inline std::vector< std::pair<size_t, double> > violations(const std::vector<double>& values, ThreadPool& pool) {
+    setInputs(values);
+    for ( size_t node : sharedNodes ) {
+      tape.compute(node);
+    }
+
+    // contiguous chunks with balanced number of owned nodes, a few per thread to compensate differences in node costs
+    size_t chunks = std::min(constraints.size(), 4 * pool.size());
+    std::vector<size_t> bounds = { 0 };
+    double target = (double)ownedNodes.size() / (double)std::max<size_t>(chunks, 1);
+    for ( size_t constraint = 1; constraint < constraints.size() && bounds.size() < chunks; constraint++ ) {
+      if ( (double)ownedStart[constraint] >= target * (double)bounds.size() ) {
+        bounds.push_back(constraint);
+      }
+    }
+    bounds.push_back(constraints.size());
+
+    std::vector< std::vector< std::pair<size_t, double> > > results(bounds.size() - 1);
+    pool.run( bounds.size() - 1, [&](size_t chunk) {
+      for ( size_t constraint = bounds[chunk]; constraint < bounds[chunk + 1]; constraint++ ) {
+        // the root of each constraint is emitted for its violation only and is the last node owned by the constraint
+        double value = 0.0;
+        for ( size_t i = ownedStart[constraint]; i < ownedStart[constraint + 1]; i++ ) {
+          value = tape.compute(ownedNodes[i]);
+        }
+        if ( value > 0.0 ) {
+          results[chunk].push_back({ constraint, value });
+        }
+      }
+    } );
+
+    std::vector< std::pair<size_t, double> > result;
+    for ( auto& chunk : results ) {
+      result.insert(result.end(), chunk.begin(), chunk.end());
+    }
+    return result;
+  }
+
+  /**
+   * @brief Returns the k constraints with the largest cumulative evaluation time, one per line.
+   */
+  inline std::string report(size_t k) const {
+    std::vector<size_t> ranking(constraints.size());
+    std::iota(ranking.begin(), ranking.end(), 0);
+    k = std::min(k, ranking.size());
+    std::partial_sort(ranking.begin(), ranking.begin() + (long)k, ranking.end(), [&](size_t lhs, size_t rhs) { return profiles[lhs].seconds > profiles[rhs].seconds; });
+    std::string result;
+    for ( size_t i = 0; i < k; i++ ) {
+      auto& profile = profiles[ranking[i]];
+      double evaluations = (double)std::max<size_t>(profile.evaluations, 1);
+      result += std::format("{:.6f} s, {} evaluations, {:.2f} % violated, {:.2f} % short-circuited: {}\n",
+        profile.seconds, profile.evaluations, 100.0 * (double)profile.violations / evaluations,
+        100.0 * (double)profile.shortCircuits / evaluations, stringify(ranking[i])
+      );
+    }
+    return result;
+  }
+
+private:
+  Tape tape;
+  std::vector< std::variant<const Expression*, const Table*, const LinearConstraint*> > constraints;
+  std::vector<size_t> outputs; ///< Output of the tape providing the violation of each constraint
+  std::vector<Profile> profiles;
+  bool profiling = false;
+  Ordering ordering = Ordering::STATIC;
+  std::vector<size_t> order;
+  std::vector<double> costs;
+  std::vector<double> activities; ///< Exponentially decayed number of rejections of each constraint
+  double increment = 1.0;
+  std::vector<size_t> sharedNodes; ///< Nodes required by more than one constraint in increasing order
+  std::vector<size_t> ownedStart; ///< Position of the first node owned by each constraint
+  std::vector<size_t> ownedNodes; ///< Nodes required by only one constraint grouped by constraint
+  inline static constexpr double decay = 0.95;
+
+  inline double score(size_t constraint) const { return activities[constraint] / costs[constraint]; };
+
+  /**
+   * @brief Adapts the order after the constraint at the given position rejected an assignment.
+   */
+  inline void reject(size_t position) {
+    size_t constraint = order[position];
+    if ( ordering == Ordering::MOVE_TO_FRONT ) {
+      std::rotate(order.begin(), order.begin() + (long)position, order.begin() + (long)position + 1);
+    }
+    else if ( ordering == Ordering::REJECTION_RATE ) {
+      // decaying all activities is emulated by increasing the increment, which preserves the order of all other constraints
+      activities[constraint] += increment;
+      increment /= decay;
+      if ( increment > 1e100 ) {
+        for ( auto& activity : activities ) {
+          activity *= 1e-100;
+        }
+        increment *= 1e-100;
+      }
+      while ( position > 0 && score(order[position - 1]) < score(constraint) ) {
+        order[position] = order[position - 1];
+        position--;
+      }
+      order[position] = constraint;
+    }
+  }
+};
+
+} // end namespace CP
@@ -0,0 +1,130 @@
+ /**
+ ******************************************************************************
+ *
+ *  Generator of synthetic scheduling models for scale testing
+ *
+ ******************************************************************************
+ */
+
+#pragma once
+
+#include <cstdint>
+
+#include "cp.h"
+
+namespace CP {
+
+/*******************************************
+ * Generator
+ ******************************************/
+
+/**
+ * @brief Parameters of a synthetic scheduling model.
+ */
+struct GeneratorParameters {
+  size_t processes = 1; ///< Number of process instances
+  size_t activities = 10; ///< Number of activities per process instance
+  size_t gateways = 2; ///< Number of exclusive gateways per process instance
+  size_t precedences = 2; ///< Number of precedence constraints per activity
+  size_t modes = 3; ///< Number of execution modes with different durations
+  size_t resources = 3; ///< Number of resources shared by all process instances
+  uint64_t seed = 0;
+};
+
+/**
+ * @brief Creates a deterministic BPMN-like scheduling model.
+ *
+ * For each process instance `p<i>`, the model contains
+ * - a sequence `p<i>_position` of the activities,
+ * - an integer variable `p<i>_mode` and indexed variables `p<i>_duration` deduced by element lookups
+ *   `n_ary_if( p<i>_mode == 1, d_1, ..., p<i>_mode == m, d_m, 0 )` like those created by LIMEX for `durations[p<i>_mode]`,
+ * - indexed variables `p<i>_start` for the start times and `p<i>_uses` for the resource usage,
+ * - precedence constraints `( position[j] < position[k] ).implies( start[k] >= start[j] + duration[j] )`,
+ * - boolean gateway variables `p<i>_gateway` implying which of two activities uses its resource,
+ * - a variable `p<i>_completion` deduced as maximum of all completion times.
+ *
+ * Resources are shared by linear constraints limiting the total demand of all activities using them, the objective
+ * is to minimize the maximum completion time. The same parameters always yield the same model.
+ */
+inline void generateSchedulingModel(Model& model, const GeneratorParameters& parameters) {
+  CP_TRACE_SCOPE("generateSchedulingModel");
+  if ( parameters.activities == 0 || parameters.modes == 0 || parameters.resources == 0 ) {
+    throw std::invalid_argument("CP: generator requires activities, modes, and resources");
+  }
+
+  // splitmix64 is used instead of the standard distributions, whose results differ between implementations
+  uint64_t state = parameters.seed;
+  auto random = [&state](uint64_t n) {
+    uint64_t z = ( state += 0x9e3779b97f4a7c15 );
+    z = ( z ^ (z >> 30) ) * 0xbf58476d1ce4e5b9;
+    z = ( z ^ (z >> 27) ) * 0x94d049bb133111eb;
+    return ( z ^ (z >> 31) ) % n;
+  };
+
+  constexpr uint64_t maxDuration = 10;
+  double horizon = (double)( parameters.activities * maxDuration );
+  std::vector< std::vector<double> > demands(parameters.resources);
+  std::vector< std::vector<std::reference_wrapper<const Variable>> > users(parameters.resources);
+  std::vector<Expression> completions;
+  completions.reserve(parameters.processes);
+
+  for ( size_t process = 0; process < parameters.processes; process++ ) {
+    std::string prefix = "p" + std::to_string(process) + "_";
+    auto position = model.addSequence(prefix + "position", parameters.activities);
+    auto& mode = model.addVariable(Variable::Type::INTEGER, prefix + "mode", 1, (double)parameters.modes);
+    auto& duration = model.addIndexedVariables(Variable::Type::INTEGER, prefix + "duration");
+    auto& start = model.addIndexedVariables(Variable::Type::INTEGER, prefix + "start");
+    auto& uses = model.addIndexedVariables(Variable::Type::BOOLEAN, prefix + "uses");
+    auto& gateway = model.addIndexedVariables(Variable::Type::BOOLEAN, prefix + "gateway");
+
+    std::vector<Expression> finish;
+    finish.reserve(parameters.activities);
+    for ( size_t activity = 0; activity < parameters.activities; activity++ ) {
+      Cases cases;
+      cases.reserve(parameters.modes);
+      for ( size_t m = 1; m <= parameters.modes; m++ ) {
+        cases.push_back( { mode == (double)m, (double)( 1 + random(maxDuration) ) } );
+      }
+      duration.emplace_back( n_ary_if( std::move(cases), 0.0 ) );
+      start.emplace_back( 0.0, horizon );
+      uses.emplace_back( 0.0, 1.0 );
+      finish.push_back( start[activity] + duration[activity] );
+
+      size_t resource = random(parameters.resources);
+      demands[resource].push_back( (double)( 1 + random(5) ) );
+      users[resource].push_back( uses[activity] );
+    }
+
+    for ( size_t activity = 1; activity < parameters.activities; activity++ ) {
+      for ( size_t i = 0; i < parameters.precedences; i++ ) {
+        size_t predecessor = random(activity);
+        model.addConstraint( ( position[predecessor] < position[activity] ).implies( start[activity] >= start[predecessor] + duration[predecessor] ) );
+      }
+    }
+
+    for ( size_t i = 0; i < parameters.gateways; i++ ) {
+      gateway.emplace_back( 0.0, 1.0 );
+      size_t first = random(parameters.activities);
+      size_t second = random(parameters.activities);
+      model.addConstraint( gateway[i].implies( uses[first] == 1.0 ) );
+      model.addConstraint( (!gateway[i]).implies( uses[second] == 1.0 ) );
+    }
+
+    auto& completion = model.addVariable(Variable::Type::INTEGER, prefix + "completion", max( std::move(finish) ));
+    completions.push_back(completion);
+  }
+
+  for ( size_t resource = 0; resource < parameters.resources; resource++ ) {
+    double capacity = 0.0;
+    for ( double demand : demands[resource] ) {
+      capacity += demand;
+    }
+    model.addConstraint( linear( std::move(demands[resource]), users[resource] ) <= std::ceil( capacity / 2 ) );
+  }
+
+  if ( !completions.empty() ) {
+    model.addObjective( Model::ObjectiveSense::MINIMIZE, max( std::move(completions) ) );
+  }
+}
+
+} // end namespace CP
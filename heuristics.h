@@ -0,0 +1,311 @@
+ /**
+ ******************************************************************************
+ *
+ *  Branching heuristics
+ *
+ ******************************************************************************
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <optional>
+#include <random>
+#include <stdexcept>
+
+#include "cp.h"
+#include "nogoods.h"
+
+namespace CP {
+
+/*******************************************
+ * Heuristic
+ ******************************************/
+
+/**
+ * @brief Interface of a branching heuristic of Search, which is informed about decisions, narrowed bounds, and failures.
+ *
+ * Inputs and constraints are identified by their index in the search, the domain of an input is given by its bounds. The
+ * events are reported in the order decided(), narrowed() for each input narrowed by propagation, and propagated(), which
+ * is followed by failed() if propagation fails. Scores should be updated in constant time per event, because the events
+ * are reported at every node.
+ */
+class Heuristic {
+public:
+  virtual ~Heuristic() = default;
+
+  /**
+   * @brief Provides the structure of the model before the search starts.
+   *
+   * @param scopes The inputs used by each constraint.
+   * @param sequences The inputs of the variables of each sequence.
+   */
+  virtual void initialize(size_t inputs, const std::vector< std::vector<size_t> >& scopes, const std::vector< std::vector<size_t> >& sequences) {
+    (void)inputs; (void)scopes; (void)sequences;
+  }
+
+  /**
+   * @brief Returns the input to branch on, or std::nullopt if all inputs are fixed.
+   */
+  virtual std::optional<size_t> select(const std::vector<Interval>& bounds) = 0;
+
+  /**
+   * @brief Returns the decision for the selected input, which must narrow the bounds without making them empty, by default `x <= lb`.
+   */
+  virtual Literal decide(size_t input, const std::vector<Interval>& bounds) { return { input, true, bounds[input].lowerBound }; };
+
+  virtual void decided(const Literal& decision, const std::vector<Interval>& bounds) { (void)decision; (void)bounds; };
+  virtual void narrowed(size_t input, const Interval& before, const Interval& after) { (void)input; (void)before; (void)after; };
+  virtual void propagated(bool feasible) { (void)feasible; };
+
+  /**
+   * @brief Reports a failure, caused by a constraint if known.
+   */
+  virtual void failed(std::optional<size_t> constraint) { (void)constraint; };
+  virtual void restarted() {};
+
+  inline void seed(uint64_t value) { random.seed(value); };
+
+protected:
+  std::mt19937_64 random;
+
+  inline static double size(const Interval& bounds) { return bounds.upperBound - bounds.lowerBound + 1.0; };
+
+  /**
+   * @brief Returns an input which is not fixed with the smallest score, breaking ties randomly.
+   */
+  template<typename Score>
+  inline std::optional<size_t> selectMinimum(const std::vector<Interval>& bounds, Score score) {
+    std::optional<size_t> selected;
+    double smallest = std::numeric_limits<double>::infinity();
+    size_t ties = 0;
+    for ( size_t input = 0; input < bounds.size(); input++ ) {
+      if ( bounds[input].lowerBound == bounds[input].upperBound ) {
+        continue;
+      }
+      double value = score(input);
+      if ( value < smallest ) {
+        selected = input;
+        smallest = value;
+        ties = 1;
+      }
+      else if ( value == smallest && std::uniform_int_distribution<size_t>(0, ties++)(random) == 0 ) {
+        selected = input;
+      }
+    }
+    return selected;
+  }
+};
+
+/*******************************************
+ * FirstFail
+ ******************************************/
+
+/**
+ * @brief Selects an input with the smallest domain.
+ */
+class FirstFail : public Heuristic {
+public:
+  inline std::optional<size_t> select(const std::vector<Interval>& bounds) override {
+    return selectMinimum(bounds, [&](size_t input) { return size(bounds[input]); });
+  }
+};
+
+/*******************************************
+ * DomWdeg
+ ******************************************/
+
+/**
+ * @brief Selects an input with the smallest ratio of domain size and weighted degree (dom/wdeg).
+ *
+ * Each constraint has a weight which is incremented whenever its propagation fails. The weighted degree of an input is
+ * the sum of the weights of the constraints using it, which is incremented together with the weights of these constraints.
+ */
+class DomWdeg : public Heuristic {
+public:
+  inline void initialize(size_t inputs, const std::vector< std::vector<size_t> >& scopes, const std::vector< std::vector<size_t> >& sequences) override {
+    (void)sequences;
+    this->scopes = scopes;
+    weights.assign(scopes.size(), 1.0);
+    degrees.assign(inputs, 0.0);
+    for ( auto& scope : scopes ) {
+      for ( size_t input : scope ) {
+        degrees[input] += 1.0;
+      }
+    }
+  }
+
+  inline std::optional<size_t> select(const std::vector<Interval>& bounds) override {
+    return selectMinimum(bounds, [&](size_t input) { return size(bounds[input]) / std::max(1.0, degrees[input]); });
+  }
+
+  inline void failed(std::optional<size_t> constraint) override {
+    if ( constraint ) {
+      weights[*constraint] += 1.0;
+      for ( size_t input : scopes[*constraint] ) {
+        degrees[input] += 1.0;
+      }
+    }
+  }
+
+  inline double getWeight(size_t constraint) const { return weights.at(constraint); };
+  inline double getWeightedDegree(size_t input) const { return degrees.at(input); };
+
+private:
+  std::vector< std::vector<size_t> > scopes;
+  std::vector<double> weights;
+  std::vector<double> degrees;
+};
+
+/*******************************************
+ * ActivityBased
+ ******************************************/
+
+/**
+ * @brief Selects an input with the highest activity, i.e. a decaying count of how often its bounds were narrowed by propagation.
+ *
+ * Instead of decaying all activities, the increment grows by the inverse of the decay after each failure, and all
+ * activities are rescaled if the increment becomes too large.
+ */
+class ActivityBased : public Heuristic {
+public:
+  inline ActivityBased(double decay = 0.95) : decay(decay) {
+    if ( decay <= 0.0 || decay > 1.0 ) {
+      throw std::invalid_argument("CP: activity requires decay in (0,1]");
+    }
+  }
+
+  inline void initialize(size_t inputs, const std::vector< std::vector<size_t> >& scopes, const std::vector< std::vector<size_t> >& sequences) override {
+    (void)scopes; (void)sequences;
+    activities.assign(inputs, 0.0);
+    increment = 1.0;
+  }
+
+  inline std::optional<size_t> select(const std::vector<Interval>& bounds) override {
+    return selectMinimum(bounds, [&](size_t input) { return -activities[input]; });
+  }
+
+  inline void narrowed(size_t input, const Interval& before, const Interval& after) override {
+    (void)before; (void)after;
+    activities[input] += increment;
+  }
+
+  inline void failed(std::optional<size_t> constraint) override {
+    (void)constraint;
+    increment /= decay;
+    if ( increment > 1e100 ) {
+      for ( auto& activity : activities ) {
+        activity *= 1e-100;
+      }
+      increment *= 1e-100;
+    }
+  }
+
+  inline double getActivity(size_t input) const { return activities.at(input) / increment; };
+
+private:
+  double decay;
+  double increment = 1.0;
+  std::vector<double> activities;
+};
+
+/*******************************************
+ * ImpactBased
+ ******************************************/
+
+/**
+ * @brief Selects an input whose decisions had the highest average impact, i.e. the relative reduction of the search space.
+ *
+ * The impact of a decision is 1 - S'/S, where S and S' are the sizes of the search space, i.e. the products of the domain
+ * sizes, before the decision and after propagation, and 1 if propagation fails. The reduction is accumulated per narrowed
+ * input as the difference of the logarithms of its domain sizes.
+ */
+class ImpactBased : public Heuristic {
+public:
+  inline void initialize(size_t inputs, const std::vector< std::vector<size_t> >& scopes, const std::vector< std::vector<size_t> >& sequences) override {
+    (void)scopes; (void)sequences;
+    impacts.assign(inputs, 0.0);
+    counts.assign(inputs, 0);
+  }
+
+  inline std::optional<size_t> select(const std::vector<Interval>& bounds) override {
+    return selectMinimum(bounds, [&](size_t input) { return -impacts[input]; });
+  }
+
+  inline void decided(const Literal& decision, const std::vector<Interval>& bounds) override {
+    current = decision.input;
+    auto after = bounds[decision.input];
+    if ( decision.upper ) {
+      after.upperBound = std::min(after.upperBound, decision.value);
+    }
+    else {
+      after.lowerBound = std::max(after.lowerBound, decision.value);
+    }
+    reduction = std::log(size(bounds[decision.input])) - std::log(size(after));
+  }
+
+  inline void narrowed(size_t input, const Interval& before, const Interval& after) override {
+    (void)input;
+    reduction += std::log(size(before)) - std::log(size(after));
+  }
+
+  inline void propagated(bool feasible) override {
+    double impact = feasible ? 1.0 - std::exp(-reduction) : 1.0;
+    counts[current]++;
+    impacts[current] += ( impact - impacts[current] ) / (double)counts[current];
+  }
+
+  inline double getImpact(size_t input) const { return impacts.at(input); };
+
+private:
+  std::vector<double> impacts;
+  std::vector<size_t> counts;
+  size_t current = 0;
+  double reduction = 0.0;
+};
+
+/*******************************************
+ * EarliestPosition
+ ******************************************/
+
+/**
+ * @brief Assigns the earliest position not yet taken in a sequence to a variable of the sequence, other inputs are selected by first-fail.
+ *
+ * After propagation, all positions smaller than the lower bound of a variable of a sequence which is not fixed are taken,
+ * so that the earliest available position is the smallest lower bound of these variables. Among the variables with this
+ * lower bound, the variable with the smallest domain is selected and the decision `x <= lb` assigns the position.
+ */
+class EarliestPosition : public Heuristic {
+public:
+  inline void initialize(size_t inputs, const std::vector< std::vector<size_t> >& scopes, const std::vector< std::vector<size_t> >& sequences) override {
+    (void)inputs; (void)scopes;
+    this->sequences = sequences;
+  }
+
+  inline std::optional<size_t> select(const std::vector<Interval>& bounds) override {
+    for ( auto& sequence : sequences ) {
+      std::optional<size_t> selected;
+      for ( size_t input : sequence ) {
+        if ( bounds[input].lowerBound == bounds[input].upperBound ) {
+          continue;
+        }
+        if ( !selected || bounds[input].lowerBound < bounds[*selected].lowerBound
+          || ( bounds[input].lowerBound == bounds[*selected].lowerBound && bounds[input].upperBound < bounds[*selected].upperBound )
+        ) {
+          selected = input;
+        }
+      }
+      if ( selected ) {
+        return selected;
+      }
+    }
+    return selectMinimum(bounds, [&](size_t input) { return size(bounds[input]); });
+  }
+
+private:
+  std::vector< std::vector<size_t> > sequences;
+};
+
+} // end namespace CP
@@ -0,0 +1,130 @@
+ /**
+ ******************************************************************************
+ *
+ *  Lock-free channel publishing incumbent solutions
+ *
+ ******************************************************************************
+ */
+
+#pragma once
+
+#include <atomic>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+namespace CP {
+
+/*******************************************
+ * IncumbentChannel
+ ******************************************/
+
+/**
+ * @brief Publishes the latest incumbent of a single producer, e.g. a search, to any number of consumers without locks.
+ *
+ * The channel owns preallocated slots, one for each consumer reading concurrently, one for the latest incumbent, and
+ * one for the incumbent being written. The producer swaps the buffer of an incumbent with the buffer of a slot which is
+ * neither the latest nor read by a consumer and publishes it by atomically swapping the index of the latest slot, which
+ * neither copies the values, nor allocates, nor waits for the consumers. A consumer pins the latest slot by
+ * incrementing its reference count and confirming that it is still the latest slot before copying it, so that a slot is
+ * never written while it is read.
+ */
+class IncumbentChannel {
+public:
+  struct Incumbent {
+    std::vector<double> values;
+    double objective = 0.0;
+    double bound = 0.0; ///< Best known bound on the objective, equal to the objective if the incumbent is optimal
+    uint64_t version = 0; ///< Number of incumbents published until this incumbent, zero if no incumbent was read
+  };
+
+  /**
+   * @param size The number of values of each incumbent.
+   * @param consumers The maximal number of consumers reading concurrently.
+   */
+  inline IncumbentChannel(size_t size, size_t consumers = 4)
+    : slots(consumers + 2)
+    , references(std::make_unique< std::atomic<size_t>[] >(consumers + 2))
+  {
+    for ( size_t slot = 0; slot < slots.size(); slot++ ) {
+      slots[slot].values.resize(size);
+      references[slot].store(0);
+    }
+  }
+
+  IncumbentChannel(const IncumbentChannel&) = delete;
+  IncumbentChannel& operator=(const IncumbentChannel&) = delete;
+
+  inline size_t size() const { return slots.front().values.size(); };
+
+  /**
+   * @brief Returns the number of incumbents published so far.
+   */
+  inline uint64_t getVersion() const { return version.load(); };
+
+  /**
+   * @brief Publishes an incumbent and returns true, or returns false if all slots are read by more consumers than the channel was created for.
+   *
+   * If the incumbent is published, the values are swapped with the buffer of a slot, so that the values afterwards hold
+   * an outdated incumbent of the same size, which the producer may overwrite with its next incumbent. Must only be
+   * called by a single thread at a time.
+   */
+  inline bool publish(std::vector<double>& values, double objective, double bound) {
+    if ( values.size() != size() ) {
+      throw std::invalid_argument("CP: number of values does not match size of incumbent channel");
+    }
+    size_t latest = current.load();
+    for ( size_t slot = 0; slot < slots.size(); slot++ ) {
+      if ( slot == latest || references[slot].load() != 0 ) {
+        continue;
+      }
+      auto& incumbent = slots[slot];
+      incumbent.values.swap(values);
+      incumbent.objective = objective;
+      incumbent.bound = bound;
+      incumbent.version = version.load() + 1;
+      current.store(slot);
+      version.store(incumbent.version);
+      return true;
+    }
+    return false;
+  }
+
+  /**
+   * @brief Copies the latest incumbent if it is newer than the given incumbent and returns true, or returns false otherwise.
+   */
+  inline bool read(Incumbent& incumbent) const {
+    while ( true ) {
+      size_t slot = current.load();
+      if ( slot == none ) {
+        return false;
+      }
+      references[slot].fetch_add(1);
+      if ( current.load() != slot ) {
+        // the slot was replaced before it was pinned
+        references[slot].fetch_sub(1);
+        continue;
+      }
+      auto& latest = slots[slot];
+      bool newer = latest.version > incumbent.version;
+      if ( newer ) {
+        incumbent.values = latest.values;
+        incumbent.objective = latest.objective;
+        incumbent.bound = latest.bound;
+        incumbent.version = latest.version;
+      }
+      references[slot].fetch_sub(1);
+      return newer;
+    }
+  }
+
+private:
+  static constexpr size_t none = std::numeric_limits<size_t>::max();
+  std::vector<Incumbent> slots;
+  std::unique_ptr< std::atomic<size_t>[] > references; ///< Number of consumers reading each slot
+  std::atomic<size_t> current = none; ///< Slot of the latest incumbent
+  std::atomic<uint64_t> version = 0;
+};
+
+} // end namespace CP
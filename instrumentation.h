@@ -0,0 +1,160 @@
+ /**
+ ******************************************************************************
+ *
+ *  Instrumentation by counters and tracing scopes
+ *
+ *  The macros CP_TRACE_SCOPE and CP_COUNT are removed by the preprocessor
+ *  unless CP_INSTRUMENTATION is defined before this header is included.
+ *
+ ******************************************************************************
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <format>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+namespace CP {
+
+/*******************************************
+ * Instrumentation
+ ******************************************/
+
+/**
+ * @brief Collects counters and the durations of traced scopes of all threads.
+ */
+class Instrumentation {
+public:
+  enum class Counter { NODES, PROPAGATIONS, BACKTRACKS, ALLOCATIONS };
+  inline static constexpr std::array<const char*,4> counterNames = { "nodes", "propagations", "backtracks", "allocations" };
+
+  /**
+   * @brief Represents a completed scope, times are in microseconds since construction of the instrumentation.
+   */
+  struct Event {
+    const char* name;
+    double start;
+    double duration;
+    size_t thread;
+  };
+
+  /**
+   * @brief Measures the time from its construction to its destruction and records it as event.
+   *
+   * Each event is recorded under a mutex, hence scopes are only placed at coarse entry points and not in functions called per node.
+   */
+  class Scope {
+  public:
+    inline Scope(const char* name) : name(name), start(std::chrono::steady_clock::now()) {};
+    inline ~Scope() { get().record(name, start, std::chrono::steady_clock::now()); };
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+  private:
+    const char* name;
+    std::chrono::steady_clock::time_point start;
+  };
+
+  inline static Instrumentation& get() {
+    static Instrumentation instance;
+    return instance;
+  }
+
+  inline void count(Counter counter, size_t n = 1) { counters[(size_t)counter].fetch_add(n, std::memory_order_relaxed); };
+  inline size_t getCount(Counter counter) const { return counters[(size_t)counter].load(std::memory_order_relaxed); };
+
+  inline void record(const char* name, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end) {
+    Event event = {
+      name,
+      std::chrono::duration<double, std::micro>(start - epoch).count(),
+      std::chrono::duration<double, std::micro>(end - start).count(),
+      std::hash<std::thread::id>()(std::this_thread::get_id())
+    };
+    std::lock_guard lock(mutex);
+    events.push_back(event);
+  }
+
+  inline std::vector<Event> getEvents() const {
+    std::lock_guard lock(mutex);
+    return events;
+  }
+
+  /**
+   * @brief Removes all events and resets all counters.
+   */
+  inline void reset() {
+    std::lock_guard lock(mutex);
+    events.clear();
+    for ( auto& counter : counters ) {
+      counter = 0;
+    }
+  }
+
+  /**
+   * @brief Returns the events in the Chrome trace event format, which can be loaded by chrome://tracing or Perfetto.
+   */
+  inline std::string chromeTrace() const {
+    std::string result = "{ \"traceEvents\": [";
+    for ( auto& event : getEvents() ) {
+      result += std::format("{}\n  {{ \"name\": \"{}\", \"ph\": \"X\", \"ts\": {:.3f}, \"dur\": {:.3f}, \"pid\": 0, \"tid\": {} }}",
+        result.back() == '[' ? "" : ",", event.name, event.start, event.duration, event.thread % 1000000
+      );
+    }
+    return result + "\n] }";
+  }
+
+  /**
+   * @brief Returns the counters and the number of calls and total microseconds per traced scope as JSON.
+   */
+  inline std::string json() const {
+    std::vector< std::tuple<const char*, size_t, double> > phases;
+    for ( auto& event : getEvents() ) {
+      auto it = std::ranges::find_if(phases, [&](auto& phase) { return std::string_view(std::get<0>(phase)) == event.name; });
+      if ( it == phases.end() ) {
+        phases.push_back({ event.name, 1, event.duration });
+      }
+      else {
+        std::get<1>(*it)++;
+        std::get<2>(*it) += event.duration;
+      }
+    }
+    std::string result = "{ \"counters\": {";
+    for ( size_t i = 0; i < counters.size(); i++ ) {
+      result += std::format("{} \"{}\": {}", i ? "," : "", counterNames[i], counters[i].load(std::memory_order_relaxed));
+    }
+    result += " }, \"phases\": {";
+    for ( auto& [name, calls, duration] : phases ) {
+      result += std::format("{} \"{}\": {{ \"calls\": {}, \"microseconds\": {:.3f} }}", result.back() == '{' ? "" : ",", name, calls, duration);
+    }
+    return result + ( phases.empty() ? "} }" : " } }" );
+  }
+
+private:
+  Instrumentation() : epoch(std::chrono::steady_clock::now()) {};
+  std::chrono::steady_clock::time_point epoch;
+  std::array<std::atomic<size_t>,4> counters = {};
+  mutable std::mutex mutex;
+  std::vector<Event> events;
+};
+
+} // end namespace CP
+
+#define CP_CONCATENATE_IMPL(a, b) a##b
+#define CP_CONCATENATE(a, b) CP_CONCATENATE_IMPL(a, b)
+
+#ifdef CP_INSTRUMENTATION
+  #define CP_TRACE_SCOPE(name) CP::Instrumentation::Scope CP_CONCATENATE(cpTraceScope, __LINE__)(name)
+  #define CP_COUNT(counter, n) CP::Instrumentation::get().count(CP::Instrumentation::Counter::counter, n)
+#else
+  #define CP_TRACE_SCOPE(name) ((void)0)
+  #define CP_COUNT(counter, n) ((void)0)
+#endif
@@ -0,0 +1,170 @@
+ /**
+ ******************************************************************************
+ *
+ *  Lazy generation of constraints violated by an assignment
+ *
+ ******************************************************************************
+ */
+
+#pragma once
+
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "cp.h"
+#include "tape.h"
+#include "feasibility_checker.h"
+
+namespace CP {
+
+/*******************************************
+ * Assignment
+ ******************************************/
+
+/**
+ * @brief Provides the values of the inputs of a tape, e.g. of a FeasibilityChecker or a Search, by variable.
+ */
+struct Assignment {
+  const Tape& tape;
+  const std::vector<double>& values;
+
+  inline double operator[](const Variable& variable) const {
+    auto input = tape.getInputIndex(variable);
+    if ( !input ) {
+      throw std::invalid_argument("CP: variable '" + variable.name + "' is not an input of the assignment");
+    }
+    return values[*input];
+  }
+};
+
+/**
+ * @brief Appends constraints of a family which are violated by an assignment, e.g. non-overlap of pairs of overlapping activities.
+ */
+using ConstraintGenerator = std::function< void(const Assignment& assignment, std::vector<Expression>& constraints) >;
+
+/*******************************************
+ * LazyConstraints
+ ******************************************/
+
+/**
+ * @brief Generates constraints of families too large to be added to a model only when an assignment violates them.
+ *
+ * Instead of adding all constraints of a family, e.g. non-overlap of all pairs of activities, to the model, a generator
+ * is registered which appends the constraints of the family violated by a given assignment. An assignment satisfying the
+ * model and the constraints generated so far is checked by querying the generators. Constraints generated for the first
+ * time are recorded and returned, so that a search can add them to its propagation and reject the assignment. Once the
+ * search is done, the generated constraints can be promoted into the model.
+ *
+ * The constraints of a generator must only use variables which are inputs of the tape of the assignment. The generators
+ * are called by the thread checking an assignment, hence an instance may be shared by consecutive searches, each of
+ * which propagates all constraints generated so far, but not by concurrent searches.
+ */
+class LazyConstraints {
+public:
+  inline void addGenerator(ConstraintGenerator generator) {
+    if ( !generator ) {
+      throw std::invalid_argument("CP: lazy constraints require generator");
+    }
+    generators.push_back(std::move(generator));
+  }
+
+  inline size_t size() const { return constraints.size(); };
+
+  /**
+   * @brief Returns the constraints generated so far in the order of their generation.
+   */
+  inline const std::vector<Expression>& getConstraints() const { return constraints; };
+
+  /**
+   * @brief Queries all generators and returns the constraints violated by the assignment which were not generated before.
+   */
+  inline std::vector<Expression> generate(const Assignment& assignment) {
+    std::vector<Expression> generated;
+    query(assignment, generated);
+    return generated;
+  }
+
+  /**
+   * @brief Returns true if the values satisfy all constraints of the checker and no generator yields a constraint.
+   */
+  inline bool isFeasible(FeasibilityChecker& checker, const std::vector<double>& values) {
+    if ( !checker.isFeasible(values) ) {
+      return false;
+    }
+    std::vector<Expression> generated;
+    return !query({ checker.getTape(), values }, generated);
+  }
+
+  /**
+   * @brief Adds the constraints generated since the last promotion to the model and returns their number.
+   *
+   * The constraints are kept as generated constraints, so that they are not returned by generate() again.
+   */
+  inline size_t promote(Model& model) {
+    size_t count = constraints.size() - promoted;
+    for ( ; promoted < constraints.size(); promoted++ ) {
+      model.addConstraint(constraints[promoted]);
+    }
+    return count;
+  }
+
+private:
+  std::vector<ConstraintGenerator> generators;
+  std::vector<Expression> constraints;
+  std::unordered_set<std::string> known; ///< Keys of the constraints generated so far
+  size_t promoted = 0; ///< Number of constraints added to the model
+
+  /**
+   * @brief Queries all generators, records the new constraints, which replace the generated constraints, and returns true if any constraint was generated.
+   */
+  inline bool query(const Assignment& assignment, std::vector<Expression>& generated) {
+    for ( auto& generator : generators ) {
+      generator(assignment, generated);
+    }
+    bool violated = !generated.empty();
+    std::erase_if(generated, [&](const Expression& constraint) { return !known.insert(key(constraint)).second; });
+    constraints.insert(constraints.end(), generated.begin(), generated.end());
+    return violated;
+  }
+
+  /**
+   * @brief Returns a key identifying the structure of a constraint with exact constants and variables given by their address.
+   */
+  inline static std::string key(const Expression& constraint) {
+    std::string result;
+    auto append = [&result](const auto& value) {
+      char bytes[sizeof(value)];
+      std::memcpy(bytes, &value, sizeof(value));
+      result.append(bytes, sizeof(value));
+    };
+    std::vector<const Expression*> stack = { &constraint };
+    while ( !stack.empty() ) {
+      auto expression = stack.back();
+      stack.pop_back();
+      append(expression->_operator);
+      append(expression->operands.size());
+      for ( auto& operand : expression->operands ) {
+        append(operand.index());
+        if ( std::holds_alternative<size_t>(operand) ) {
+          append(std::get<size_t>(operand));
+        }
+        else if ( std::holds_alternative<double>(operand) ) {
+          append(std::get<double>(operand));
+        }
+        else if ( std::holds_alternative<std::reference_wrapper<const Variable>>(operand) ) {
+          append(&std::get<std::reference_wrapper<const Variable>>(operand).get());
+        }
+        else {
+          stack.push_back(&std::get<Expression>(operand));
+        }
+      }
+    }
+    return result;
+  }
+};
+
+} // end namespace CP
@@ -66,6 +66,27 @@ void LIMEX::Callables<CP::Expression>::initialize() {
     }
   );
 
+  for ( std::string name : { "piecewise_linear", "step" } ) {
+    add(
+      name, 
+      [name](const std::vector<CP::Expression>& args)
+      {
+        if (args.size() < 3 || args.size() % 2 == 0) throw std::runtime_error("LIMEX: " + name + "() requires an argument followed by pairs of breakpoint coordinates");
+        CP::Breakpoints breakpoints;
+        for (size_t i = 1; i < args.size(); i += 2) {
+          if (
+            args[i]._operator != CP::Expression::Operator::none || !std::holds_alternative<double>(args[i].operands.front()) ||
+            args[i+1]._operator != CP::Expression::Operator::none || !std::holds_alternative<double>(args[i+1].operands.front())
+          ) {
+            throw std::runtime_error("LIMEX: " + name + "() requires constant breakpoints");
+          }
+          breakpoints.emplace_back( std::get<double>(args[i].operands.front()), std::get<double>(args[i+1].operands.front()) );
+        }
+        return name == "step" ? CP::step(args[0], breakpoints) : CP::piecewise_linear(args[0], breakpoints);
+      }
+    );
+  }
+
   add(
     std::string("sum"), 
     [](const std::vector<CP::Expression>& args)
@@ -0,0 +1,428 @@
+ /**
+ ******************************************************************************
+ *
+ *  Incremental evaluation and bound propagation of linear constraints
+ *
+ ******************************************************************************
+ */
+
+#pragma once
+
+#include <cmath>
+#include <algorithm>
+#include <optional>
+#include <unordered_map>
+#include <stdexcept>
+
+#include "cp.h"
+
+namespace CP {
+
+/*******************************************
+ * LinearEvaluator
+ ******************************************/
+
+/**
+ * @brief Maintains the left-hand sides and violations of linear constraints under changes of single variables.
+ *
+ * The terms of all constraints and the occurrences of all variables are stored contiguously, so that changing
+ * the value of a variable updates each constraint containing the variable in constant time.
+ *
+ * Penalties are maintained per level: level 0 is the total violation of all hard constraints, the other levels
+ * are the weighted violations of the soft constraints ordered by decreasing priority.
+ */
+class LinearEvaluator {
+public:
+  /**
+   * @brief Creates an evaluator for all linear constraints and all linear soft constraints of a model.
+   */
+  inline LinearEvaluator(const Model& model) {
+    CP_TRACE_SCOPE("LinearEvaluator::LinearEvaluator");
+    for ( auto& constraint : model.getLinearConstraints() ) {
+      add(constraint);
+    }
+    for ( auto& softConstraint : model.getSoftConstraints() ) {
+      if ( std::holds_alternative<LinearConstraint>(softConstraint.constraint) ) {
+        add(std::get<LinearConstraint>(softConstraint.constraint), softConstraint.weight, softConstraint.priority);
+      }
+    }
+    finalize();
+  }
+
+  inline LinearEvaluator(const std::vector<const LinearConstraint*>& constraints) {
+    for ( auto constraint : constraints ) {
+      add(*constraint);
+    }
+    finalize();
+  }
+
+  inline const std::vector<const Variable*>& getVariables() const { return variables; };
+  inline const std::vector<const LinearConstraint*>& getConstraints() const { return constraints; };
+  inline bool isSoft(size_t constraint) const { return levels[constraint] > 0; };
+
+  /**
+   * @brief Returns the position of a variable or std::nullopt if the variable does not occur in any of the constraints.
+   */
+  inline std::optional<size_t> getIndex(const Variable& variable) const {
+    auto it = variableIndex.find(&variable);
+    if ( it == variableIndex.end() ) {
+      return std::nullopt;
+    }
+    return it->second;
+  }
+
+  /**
+   * @brief Sets the values of all variables in the order of getVariables() and evaluates all constraints.
+   */
+  inline void initialize(const std::vector<double>& values) {
+    if ( values.size() != variables.size() ) {
+      throw std::invalid_argument("CP: number of values does not match number of variables of evaluator");
+    }
+    this->values = values;
+    lhs.assign(constraints.size(), 0.0);
+    violations.assign(constraints.size(), 0.0);
+    penalties.assign(penalties.size(), 0.0);
+    violated = 0;
+    for ( size_t constraint = 0; constraint < constraints.size(); constraint++ ) {
+      for ( size_t term = termStart[constraint]; term < termStart[constraint + 1]; term++ ) {
+        lhs[constraint] += termCoefficients[term] * values[termVariables[term]];
+      }
+      update(constraint);
+    }
+  }
+
+  /**
+   * @brief Changes the value of a variable and updates all constraints containing the variable.
+   */
+  inline void set(size_t variable, double value) {
+    double delta = value - values[variable];
+    if ( delta == 0.0 ) {
+      return;
+    }
+    values[variable] = value;
+    for ( size_t occurrence = occurrenceStart[variable]; occurrence < occurrenceStart[variable + 1]; occurrence++ ) {
+      size_t constraint = occurrenceConstraints[occurrence];
+      lhs[constraint] += occurrenceCoefficients[occurrence] * delta;
+      update(constraint);
+    }
+  }
+
+  /**
+   * @brief Returns the change of the total violation of the hard constraints if the value of a variable were changed, without changing it.
+   */
+  inline double delta(size_t variable, double value) const {
+    double delta = value - values[variable];
+    double result = 0.0;
+    for ( size_t occurrence = occurrenceStart[variable]; occurrence < occurrenceStart[variable + 1]; occurrence++ ) {
+      size_t constraint = occurrenceConstraints[occurrence];
+      if ( !isSoft(constraint) ) {
+        result += weights[constraint] * ( constraints[constraint]->violation( lhs[constraint] + occurrenceCoefficients[occurrence] * delta ) - violations[constraint] );
+      }
+    }
+    return result;
+  }
+
+  /**
+   * @brief Returns the change of the penalty of each level if the value of a variable were changed, without changing it.
+   */
+  inline std::vector<double> penaltyDelta(size_t variable, double value) const {
+    std::vector<double> deltas;
+    penaltyDelta(variable, value, deltas);
+    return deltas;
+  }
+
+  /**
+   * @brief Stores the change of the penalty of each level in deltas if the value of a variable were changed, without changing it.
+   *
+   * The vector is resized to the number of levels, hence a vector reused by the caller is not reallocated.
+   */
+  inline void penaltyDelta(size_t variable, double value, std::vector<double>& deltas) const {
+    double delta = value - values[variable];
+    deltas.assign(penalties.size(), 0.0);
+    for ( size_t occurrence = occurrenceStart[variable]; occurrence < occurrenceStart[variable + 1]; occurrence++ ) {
+      size_t constraint = occurrenceConstraints[occurrence];
+      double violation = constraints[constraint]->violation( lhs[constraint] + occurrenceCoefficients[occurrence] * delta );
+      deltas[levels[constraint]] += weights[constraint] * ( violation - violations[constraint] );
+    }
+  }
+
+  /**
+   * @brief Returns true if the first level with a non-negligible change of penalty improves.
+   */
+  inline static bool isImprovement(const std::vector<double>& penaltyDeltas) {
+    for ( double delta : penaltyDeltas ) {
+      if ( std::abs(delta) > tolerance ) {
+        return delta < 0.0;
+      }
+    }
+    return false;
+  }
+
+  inline double getValue(size_t variable) const { return values[variable]; };
+  inline double getLhs(size_t constraint) const { return lhs[constraint]; };
+  inline double getViolation(size_t constraint) const { return violations[constraint]; };
+  inline double getTotalViolation() const { return penalties[0]; };
+  inline size_t getViolatedCount() const { return violated; };
+
+  /**
+   * @brief Returns the penalty of each level, starting with the total violation of the hard constraints.
+   */
+  inline const std::vector<double>& getPenalties() const { return penalties; };
+
+  /**
+   * @brief Returns the priority of the soft constraints of a level greater than 0.
+   */
+  inline size_t getPriority(size_t level) const { return priorities.at(level - 1); };
+
+  /**
+   * @brief Tightens the bounds of the variables until a fixpoint is reached and returns false if the constraints cannot be satisfied within the bounds.
+   *
+   * Each constraint is revised in time linear in its number of terms and revised again only if the bounds of one of its variables changed.
+   * Bounds of integer and boolean variables are rounded. The propagation queue is reused by subsequent calls, hence
+   * concurrent propagation requires a copy of the evaluator per thread.
+   *
+   * @param bounds The bounds of the variables in the order of getVariables().
+   */
+  inline bool propagate(std::vector<Interval>& bounds) {
+    if ( bounds.size() != variables.size() ) {
+      throw std::invalid_argument("CP: number of bounds does not match number of variables of evaluator");
+    }
+    // each constraint is queued at most once, so a ring buffer of fixed size suffices
+    queue.resize(constraints.size());
+    queued.assign(constraints.size(), false);
+    head = 0;
+    length = 0;
+    for ( size_t constraint = 0; constraint < constraints.size(); constraint++ ) {
+      // soft constraints must not restrict the bounds
+      if ( !isSoft(constraint) ) {
+        enqueue(constraint);
+      }
+    }
+    while ( length ) {
+      size_t constraint = queue[head];
+      head = ( head + 1 ) % queue.size();
+      length--;
+      queued[constraint] = false;
+      CP_COUNT(PROPAGATIONS, 1);
+      auto op = constraints[constraint]->_operator;
+      if ( op != Expression::Operator::greater_or_equal && !revise(constraint, bounds, 1.0) ) {
+        return false;
+      }
+      if ( op != Expression::Operator::less_or_equal && !revise(constraint, bounds, -1.0) ) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+private:
+  std::vector<const LinearConstraint*> constraints;
+  std::vector<double> weights;
+  std::vector<size_t> levels; ///< Penalty level of each constraint, 0 for hard constraints
+  std::vector<size_t> priorities; ///< Priority of each level greater than 0
+  std::vector<const Variable*> variables;
+  std::unordered_map<const Variable*, size_t> variableIndex;
+  // terms of each constraint
+  std::vector<size_t> termStart;
+  std::vector<size_t> termVariables;
+  std::vector<double> termCoefficients;
+  // occurrences of each variable
+  std::vector<size_t> hard; ///< Hard constraints added before finalize()
+  std::vector<size_t> occurrenceStart;
+  std::vector<size_t> occurrenceConstraints;
+  std::vector<double> occurrenceCoefficients;
+  // state
+  std::vector<double> values;
+  std::vector<double> lhs;
+  std::vector<double> violations;
+  std::vector<double> penalties;
+  // propagation queue
+  std::vector<size_t> queue;
+  std::vector<bool> queued;
+  size_t head = 0;
+  size_t length = 0;
+  size_t violated = 0;
+
+  inline static constexpr double tolerance = 1e-9;
+
+  /**
+   * @brief Adds a hard constraint or, if a weight is given, a soft constraint whose priority is temporarily stored as level.
+   *
+   * Terms of the same variable are merged into a single term, so that each occurrence of a variable updates the
+   * left-hand side by its total coefficient.
+   */
+  inline void add(const LinearConstraint& constraint, std::optional<double> weight = std::nullopt, size_t priority = 0) {
+    if ( termStart.empty() ) {
+      termStart.push_back(0);
+    }
+    constraints.push_back(&constraint);
+    weights.push_back(weight.value_or(1.0));
+    levels.push_back(priority);
+    if ( weight ) {
+      priorities.push_back(priority);
+    }
+    else {
+      hard.push_back(constraints.size() - 1);
+    }
+    std::unordered_map<size_t, size_t> terms; ///< Term of each variable of the constraint
+    for ( size_t i = 0; i < constraint.variables.size(); i++ ) {
+      auto [it, inserted] = variableIndex.try_emplace(&constraint.variables[i], variables.size());
+      if ( inserted ) {
+        variables.push_back(&constraint.variables[i]);
+      }
+      auto [term, added] = terms.try_emplace(it->second, termVariables.size());
+      if ( !added ) {
+        termCoefficients[term->second] += constraint.coefficients[i];
+        continue;
+      }
+      termVariables.push_back(it->second);
+      termCoefficients.push_back(constraint.coefficients[i]);
+    }
+    termStart.push_back(termVariables.size());
+  }
+
+  inline void finalize() {
+    if ( termStart.empty() ) {
+      termStart.push_back(0);
+    }
+    // map priorities to levels in decreasing order
+    std::sort(priorities.begin(), priorities.end(), std::greater<size_t>());
+    priorities.erase( std::unique(priorities.begin(), priorities.end()), priorities.end() );
+    for ( size_t constraint = 0; constraint < constraints.size(); constraint++ ) {
+      levels[constraint] = 1 + (size_t)( std::lower_bound(priorities.begin(), priorities.end(), levels[constraint], std::greater<size_t>()) - priorities.begin() );
+    }
+    for ( size_t constraint : hard ) {
+      levels[constraint] = 0;
+    }
+    hard.clear();
+    penalties.assign(priorities.size() + 1, 0.0);
+
+    occurrenceStart.assign(variables.size() + 1, 0);
+    for ( size_t variable : termVariables ) {
+      occurrenceStart[variable + 1]++;
+    }
+    for ( size_t variable = 0; variable < variables.size(); variable++ ) {
+      occurrenceStart[variable + 1] += occurrenceStart[variable];
+    }
+    occurrenceConstraints.resize(termVariables.size());
+    occurrenceCoefficients.resize(termVariables.size());
+    std::vector<size_t> next(occurrenceStart.begin(), occurrenceStart.end() - 1);
+    for ( size_t constraint = 0; constraint < constraints.size(); constraint++ ) {
+      for ( size_t term = termStart[constraint]; term < termStart[constraint + 1]; term++ ) {
+        size_t occurrence = next[termVariables[term]]++;
+        occurrenceConstraints[occurrence] = constraint;
+        occurrenceCoefficients[occurrence] = termCoefficients[term];
+      }
+    }
+    values.assign(variables.size(), 0.0);
+    lhs.assign(constraints.size(), 0.0);
+    violations.assign(constraints.size(), 0.0);
+    for ( size_t constraint = 0; constraint < constraints.size(); constraint++ ) {
+      update(constraint);
+    }
+  }
+
+  inline void update(size_t constraint) {
+    double violation = constraints[constraint]->violation(lhs[constraint]);
+    penalties[levels[constraint]] += weights[constraint] * ( violation - violations[constraint] );
+    if ( levels[constraint] == 0 && ( violation > 0.0 ) != ( violations[constraint] > 0.0 ) ) {
+      violation > 0.0 ? violated++ : violated--;
+    }
+    violations[constraint] = violation;
+  }
+
+  inline static bool isInfinite(double value) {
+    return value <= std::numeric_limits<double>::lowest() || value >= std::numeric_limits<double>::max();
+  }
+
+  /**
+   * @brief Appends a constraint to the circular propagation queue.
+   */
+  inline void enqueue(size_t constraint) {
+    queued[constraint] = true;
+    queue[( head + length ) % queue.size()] = constraint;
+    length++;
+  }
+
+  /**
+   * @brief Revises the bounds for `sign * lhs <= sign * rhs` using the minimal activity of the left-hand side.
+   */
+  inline bool revise(size_t constraint, std::vector<Interval>& bounds, double sign) {
+    double rhs = sign * constraints[constraint]->rhs;
+    // minimal activity given by its finite part and the number of unbounded terms
+    auto minimum = [&](size_t term) {
+      double coefficient = sign * termCoefficients[term];
+      auto& [lowerBound, upperBound] = bounds[termVariables[term]];
+      double bound = coefficient > 0.0 ? lowerBound : upperBound;
+      return isInfinite(bound) ? std::nullopt : std::optional<double>(coefficient * bound);
+    };
+    double finite = 0.0;
+    size_t unbounded = 0;
+    for ( size_t term = termStart[constraint]; term < termStart[constraint + 1]; term++ ) {
+      if ( termCoefficients[term] == 0.0 ) {
+        continue;
+      }
+      auto activity = minimum(term);
+      activity ? finite += activity.value() : unbounded++;
+    }
+    if ( unbounded == 0 && finite > rhs + tolerance * std::max(1.0, std::abs(rhs)) ) {
+      return false;
+    }
+    if ( unbounded > 1 ) {
+      return true;
+    }
+
+    for ( size_t term = termStart[constraint]; term < termStart[constraint + 1]; term++ ) {
+      double coefficient = sign * termCoefficients[term];
+      if ( coefficient == 0.0 ) {
+        continue;
+      }
+      auto activity = minimum(term);
+      if ( unbounded == 1 && activity ) {
+        continue;
+      }
+      // coefficient * x <= rhs - (minimal activity of all other terms)
+      double slack = rhs - ( activity ? finite - activity.value() : finite );
+      size_t variable = termVariables[term];
+      auto& [lowerBound, upperBound] = bounds[variable];
+      bool integral = variables[variable]->type != Variable::Type::REAL;
+      bool changed = false;
+      if ( coefficient > 0.0 ) {
+        double bound = slack / coefficient;
+        if ( integral ) {
+          bound = std::floor(bound + tolerance);
+        }
+        if ( bound < upperBound - tolerance * std::max(1.0, std::abs(bound)) ) {
+          upperBound = bound;
+          changed = true;
+        }
+      }
+      else {
+        double bound = slack / coefficient;
+        if ( integral ) {
+          bound = std::ceil(bound - tolerance);
+        }
+        if ( bound > lowerBound + tolerance * std::max(1.0, std::abs(bound)) ) {
+          lowerBound = bound;
+          changed = true;
+        }
+      }
+      if ( lowerBound > upperBound + tolerance * std::max(1.0, std::abs(upperBound)) ) {
+        return false;
+      }
+      if ( changed ) {
+        // the opposite direction of an equality may tighten further after a bound changed
+        bool equality = constraints[constraint]->_operator == Expression::Operator::equal;
+        for ( size_t occurrence = occurrenceStart[variable]; occurrence < occurrenceStart[variable + 1]; occurrence++ ) {
+          size_t other = occurrenceConstraints[occurrence];
+          if ( ( other != constraint || equality ) && !queued[other] && !isSoft(other) ) {
+            enqueue(other);
+          }
+        }
+      }
+    }
+    return true;
+  }
+};
+
+} // end namespace CP
@@ -1,7 +1,25 @@
 #include <iostream>
 #include <cassert>
 
+#define CP_INSTRUMENTATION
 #include "cp.h"
+#include "tape.h"
+#include "linear_evaluator.h"
+#include "objectives.h"
+#include "generator.h"
+#include "feasibility_checker.h"
+#include "thread_pool.h"
+#include "conflicts.h"
+#include "repair.h"
+#include "specialization.h"
+#include "symmetry.h"
+#include "probing.h"
+#include "search.h"
+#include "heuristics.h"
+#include "incumbent_channel.h"
+#include "portfolio.h"
+#include "lazy_constraints.h"
+#include "allocation_counter.h"
 
 #define USE_LIMEX
 #ifdef USE_LIMEX
@@ -107,6 +125,1255 @@ int main()
   }
   std::cout << model.stringify() << std::endl;
 
+  {
+    CP::Model nlp(CP::Model::ObjectiveSense::MINIMIZE);
+    auto& t1 = nlp.addRealVariable("t1");
+    auto& t2 = nlp.addRealVariable("t2");
+    auto& d = nlp.addVariable(CP::Variable::Type::REAL, "d", t2 - t1);
+    nlp.setObjective( d * d + CP::customOperator("sqrt", t2) );
+    nlp.addConstraint( t1 + t2 <= 3 );
+    nlp.addConstraint( d >= 2 );
+    CP::Tape tape(nlp);
+    assert( tape.getInputs().size() == 2 );
+    assert( tape.getInputIndex(t1) && tape.getInputIndex(t2) && !tape.getInputIndex(d) );
+    size_t i1 = tape.getInputIndex(t1).value();
+    size_t i2 = tape.getInputIndex(t2).value();
+    std::vector<double> values(2);
+    values[i1] = 1.0;
+    values[i2] = 4.0;
+    tape.forward(values);
+    assert( tape.getValue(0) == 11.0 );
+    assert( tape.getValue(1) == 2.0 );
+    assert( tape.getValue(2) == 0.0 );
+    auto gradient = tape.gradient({1.0, 1.0, 1.0});
+    assert( gradient[i1] == -6.0 + 1.0 );
+    assert( gradient[i2] == 6.0 + 0.25 + 1.0 );
+    auto jacobian = tape.jacobian();
+    assert( jacobian.size() == 4 );
+    assert( jacobian[0].row == 0 && jacobian[0].column == 0 && jacobian[0].value == ( i1 == 0 ? -6.0 : 6.25 ) );
+    assert( jacobian[1].row == 0 && jacobian[1].column == 1 && jacobian[1].value == ( i1 == 1 ? -6.0 : 6.25 ) );
+    assert( jacobian[2].row == 1 && jacobian[2].column == 0 && jacobian[2].value == 1.0 );
+    assert( jacobian[3].row == 1 && jacobian[3].column == 1 && jacobian[3].value == 1.0 );
+  }
+
+  {
+    CP::Model tariffs;
+    auto& t = tariffs.addVariable(CP::Variable::Type::REAL, "t", 0, 10);
+    auto tariff = CP::piecewise_linear( t, { {2, 1}, {4, 5}, {8, 3} } );
+    assert( tariff.stringify() == "piecewise_linear( t, 2.00, 1.00, 4.00, 5.00, 8.00, 3.00 )" );
+    auto penalty = CP::step( t, { {2, 1}, {4, 5}, {8, 3} } );
+    CP::Tape tape;
+    tape.addOutput(tariff);
+    tape.addOutput(penalty);
+    std::vector<std::pair<double,double>> tariffValues = { {0, 1}, {2, 1}, {3, 3}, {4, 5}, {6, 4}, {8, 3}, {9, 3} };
+    for ( auto [value, expected] : tariffValues ) {
+      tape.forward({value});
+      assert( tape.getValue(0) == expected );
+    }
+    tape.forward({3.0});
+    assert( tape.getValue(1) == 1.0 );
+    assert( tape.gradient({1.0, 0.0})[0] == 2.0 );
+    tape.forward({8.0});
+    assert( tape.getValue(1) == 3.0 );
+    tape.bounds();
+    assert( tape.getBounds(0).lowerBound == 1.0 && tape.getBounds(0).upperBound == 5.0 );
+    tape.bounds({ {2.5, 3.5} });
+    assert( tape.getBounds(0).lowerBound == 2.0 && tape.getBounds(0).upperBound == 4.0 );
+    assert( tape.getBounds(1).lowerBound == 1.0 && tape.getBounds(1).upperBound == 1.0 );
+    tape.bounds({ {3.0, 5.0} });
+    assert( tape.getBounds(1).lowerBound == 1.0 && tape.getBounds(1).upperBound == 5.0 );
+
+    auto value = tariffs.addLinearization( "tariff", tariff, t.lowerBound, t.upperBound );
+    assert( tariffs.getIndexedVariables().front().size() == 3 );
+    assert( tariffs.getIndexedVariables().back().size() == 4 );
+    assert( tariffs.getConstraints().back().stringify() == "t == ( ( ( 0.00 + ( 2.00 * tariff_delta[0] ) ) + ( 2.00 * tariff_delta[1] ) ) + ( 4.00 * tariff_delta[2] ) ) + ( 2.00 * tariff_delta[3] )" );
+    assert( value.stringify() == "( 1.00 + ( 4.00 * tariff_delta[1] ) ) + ( -2.00 * tariff_delta[2] )" );
+    tariffs.addLinearization( "penalty", penalty );
+    assert( tariffs.getConstraints().back().stringify() == "( !( !penalty_z[1] ) ) || ( t < 8.00 )" );
+    tariffs.addLinearization( "derived", tariff );
+    assert( tariffs.getIndexedVariables().back().size() == 4 );
+    assert( tariffs.getConstraints().back().stringify() == "t == ( ( ( 0.00 + ( 2.00 * derived_delta[0] ) ) + ( 2.00 * derived_delta[1] ) ) + ( 4.00 * derived_delta[2] ) ) + ( 2.00 * derived_delta[3] )" );
+    bool thrown = false;
+    try {
+      tariffs.addLinearization( "shifted", CP::piecewise_linear( t + 1, { {2, 1}, {4, 5} } ) );
+    }
+    catch ( const std::invalid_argument& ) {
+      thrown = true;
+    }
+    assert( thrown );
+  }
+
+  {
+    CP::Model compatibility;
+    auto& resource = compatibility.addVariable(CP::Variable::Type::INTEGER, "resource", 0, 9);
+    auto& activity = compatibility.addVariable(CP::Variable::Type::INTEGER, "activity", 0, 9);
+    auto& allowed = compatibility.addTable( {resource, activity}, { {1, 1}, {1, 2}, {2, 3}, {3, 1} } );
+    assert( allowed.stringify() == "( resource, activity ) ∈ { ( 1.00, 1.00 ), ( 1.00, 2.00 ), ( 2.00, 3.00 ), ( 3.00, 1.00 ) }" );
+    assert( allowed.size() == 4 && allowed.arity() == 2 );
+    assert( allowed.contains({1, 2}) && allowed.contains({3, 1}) );
+    assert( !allowed.contains({2, 1}) && !allowed.contains({4, 1}) );
+
+    std::vector<CP::Interval> bounds = { {2, 9}, {0, 2} };
+    assert( allowed.propagate(bounds) );
+    assert( bounds[0].lowerBound == 3 && bounds[0].upperBound == 3 );
+    assert( bounds[1].lowerBound == 1 && bounds[1].upperBound == 1 );
+    bounds = { {2, 2}, {0, 2} };
+    assert( !allowed.propagate(bounds) );
+
+    auto& forbidden = compatibility.addTable( {resource, activity}, { {1, 1}, {1, 2}, {1, 9} }, CP::Table::Type::FORBIDDEN );
+    assert( forbidden.isSatisfied({1, 3}) && !forbidden.isSatisfied({1, 2}) );
+    bounds = { {1, 1}, {1, 9} };
+    assert( forbidden.propagate(bounds) );
+    assert( bounds[1].lowerBound == 3 && bounds[1].upperBound == 8 );
+
+    std::vector<std::vector<double>> tuples;
+    for ( size_t i = 0; i < 200; i++ ) {
+      tuples.push_back({ (double)(i % 7), (double)i });
+    }
+    auto& large = compatibility.addTable( {resource, activity}, tuples );
+    assert( large.contains({ 150 % 7, 150 }) && !large.contains({ 150 % 7 + 1, 150 }) );
+
+    CP::Tape tape(compatibility);
+    assert( tape.getOutputs().size() == 4 );
+    tape.forward({ 3, 1 });
+    assert( tape.getValue(1) == 0.0 && tape.getValue(2) == 0.0 && tape.getValue(3) == 1.0 );
+    tape.bounds({ {2, 2}, {0, 2} });
+    assert( tape.getBounds(1).lowerBound == 1.0 );
+  }
+
+  {
+    CP::Model resources;
+    auto& b1 = resources.addBinaryVariable("b1");
+    auto& b2 = resources.addBinaryVariable("b2");
+    auto& b3 = resources.addBinaryVariable("b3");
+    auto& start = resources.addVariable(CP::Variable::Type::INTEGER, "start", 0, 100);
+    auto& c1 = resources.addConstraint( CP::linear( {2, 3, 4}, {b1, b2, b3} ) <= 5 );
+    assert( c1.stringify() == "2.00 * b1 + 3.00 * b2 + 4.00 * b3 <= 5.00" );
+    auto& c2 = resources.addConstraint( CP::atleast( 1, {b1, b2, b3} ) );
+    assert( c2.stringify() == "1.00 * b1 + 1.00 * b2 + 1.00 * b3 >= 1.00" );
+    resources.addConstraint( CP::atmost( 1, {b2, b3} ) );
+    resources.addConstraint( CP::linear( {1, -10}, {start, b3} ) >= 7 );
+    assert( resources.getLinearConstraints().size() == 4 );
+
+    CP::LinearEvaluator evaluator(resources);
+    assert( evaluator.getVariables().size() == 4 );
+    size_t i1 = evaluator.getIndex(b1).value();
+    size_t i2 = evaluator.getIndex(b2).value();
+    size_t i3 = evaluator.getIndex(b3).value();
+    size_t is = evaluator.getIndex(start).value();
+    std::vector<double> values(4, 0.0);
+    evaluator.initialize(values);
+    assert( evaluator.getViolatedCount() == 2 );
+    assert( evaluator.getTotalViolation() == 8.0 );
+    assert( evaluator.delta(i3, 1.0) == -1.0 + 10.0 );
+    evaluator.set(i2, 1.0);
+    evaluator.set(is, 7.0);
+    assert( evaluator.getViolatedCount() == 0 && evaluator.getTotalViolation() == 0.0 );
+    evaluator.set(i3, 1.0);
+    assert( evaluator.getLhs(0) == 7.0 && evaluator.getViolatedCount() == 3 );
+    assert( evaluator.getTotalViolation() == 2.0 + 1.0 + 10.0 );
+
+    std::vector<CP::Interval> bounds(4);
+    bounds[i1] = {0, 1};
+    bounds[i2] = {0, 1};
+    bounds[i3] = {1, 1};
+    bounds[is] = {0, 100};
+    assert( evaluator.propagate(bounds) );
+    assert( bounds[i1].upperBound == 0.0 && bounds[i2].upperBound == 0.0 );
+    assert( bounds[is].lowerBound == 17.0 && bounds[is].upperBound == 100.0 );
+    bounds[i1] = {1, 1};
+    bounds[i2] = {0, 1};
+    bounds[i3] = {1, 1};
+    assert( !evaluator.propagate(bounds) );
+
+    CP::Tape tape(resources);
+    tape.forward({ 1, 0, 1, 0 });
+    assert( tape.getValue(1) == 1.0 && tape.getValue(4) == 17.0 );
+    assert( tape.gradient({ 0, 0, 0, 0, 1 })[tape.getInputIndex(start).value()] == -1.0 );
+  }
+
+  {
+    CP::Model preferences;
+    auto& early = preferences.addBinaryVariable("early");
+    auto& late = preferences.addBinaryVariable("late");
+    auto& finish = preferences.addVariable(CP::Variable::Type::INTEGER, "finish", 0, 10);
+    preferences.addConstraint( CP::linear( {1, 1}, {early, late} ) == 1 );
+    auto& s1 = preferences.addConstraint( CP::linear( {1}, {finish} ) <= 4, 1000.0, 0 );
+    assert( s1.stringify() == "[ weight 1000.00, priority 0 ] 1.00 * finish <= 4.00" );
+    preferences.addConstraint( CP::linear( {1}, {late} ) <= 0, 1.0, 1 );
+    preferences.addConstraint( CP::linear( {1, -10}, {finish, early} ) >= 0 );
+    auto& s2 = preferences.addConstraint( finish >= 8, 2.0, 1 );
+    assert( s2.stringify() == "[ weight 2.00, priority 1 ] finish >= 8.00" );
+    assert( preferences.getSoftConstraints().size() == 3 );
+
+    CP::LinearEvaluator evaluator(preferences);
+    assert( evaluator.getConstraints().size() == 4 );
+    assert( evaluator.getPenalties().size() == 3 );
+    assert( evaluator.getPriority(1) == 1 && evaluator.getPriority(2) == 0 );
+    size_t ie = evaluator.getIndex(early).value();
+    size_t il = evaluator.getIndex(late).value();
+    size_t ifinish = evaluator.getIndex(finish).value();
+    std::vector<double> values(3);
+    values[ie] = 0;
+    values[il] = 1;
+    values[ifinish] = 3;
+    evaluator.initialize(values);
+    assert( evaluator.getPenalties()[0] == 0.0 && evaluator.getPenalties()[1] == 1.0 && evaluator.getPenalties()[2] == 0.0 );
+    // the priority 1 penalty dominates the large weight of the priority 0 penalty
+    evaluator.set(il, 0);
+    evaluator.set(ie, 1);
+    assert( evaluator.getPenalties()[0] == 7.0 );
+    auto deltas = evaluator.penaltyDelta(ifinish, 10);
+    assert( deltas[0] == -7.0 && deltas[1] == 0.0 && deltas[2] == 6000.0 );
+    assert( CP::LinearEvaluator::isImprovement(deltas) );
+    evaluator.set(ifinish, 10);
+    assert( evaluator.getViolatedCount() == 0 && evaluator.getPenalties()[2] == 6000.0 );
+    assert( !CP::LinearEvaluator::isImprovement( evaluator.penaltyDelta(ie, 0) ) );
+
+    std::vector<CP::Interval> bounds(3);
+    bounds[ie] = {1, 1};
+    bounds[il] = {0, 1};
+    bounds[ifinish] = {0, 10};
+    assert( evaluator.propagate(bounds) );
+    assert( bounds[il].upperBound == 0.0 && bounds[ifinish].lowerBound == 10.0 );
+
+    CP::Tape tape(preferences);
+    assert( tape.getOutputs().size() == 1 + 2 + 3 );
+  }
+
+  {
+    CP::Model schedule;
+    assert( schedule.getObjectives().size() == 1 );
+    auto& lateness = schedule.addVariable(CP::Variable::Type::REAL, "lateness", 0, 10);
+    auto& cost = schedule.addVariable(CP::Variable::Type::REAL, "cost", 0, 100);
+    schedule.addObjective( CP::Model::ObjectiveSense::MINIMIZE, 2 * lateness );
+    schedule.addObjective( CP::Model::ObjectiveSense::MAXIMIZE, -cost );
+    assert( schedule.getObjectiveSense() == CP::Model::ObjectiveSense::MINIMIZE );
+    assert( schedule.getObjective().stringify() == "2.00 * lateness" );
+    assert( schedule.getObjectives().size() == 2 );
+    schedule.addConstraint( lateness + cost >= 5 );
+
+    CP::Tape tape(schedule);
+    assert( tape.getOutputs().size() == 3 );
+    std::vector<double> values(2);
+    values[tape.getInputIndex(lateness).value()] = 1;
+    values[tape.getInputIndex(cost).value()] = 3;
+    tape.forward(values);
+    std::vector<double> incumbent = { tape.getValue(0), tape.getValue(1) };
+    assert( incumbent[0] == 2.0 && incumbent[1] == -3.0 && tape.getValue(2) == 1.0 );
+
+    auto senses = CP::getObjectiveSenses(schedule);
+    assert( CP::isLexicographicallyBetter( {2, -1}, incumbent, senses ) );
+    assert( !CP::isLexicographicallyBetter( {4, 0}, incumbent, senses ) );
+    assert( !CP::mayImprove( { {2, 8}, {-9, -3} }, incumbent, senses ) );
+    assert( CP::mayImprove( { {2, 8}, {-9, -2} }, incumbent, senses ) );
+    assert( CP::mayImprove( { {0, 8}, {-9, -9} }, incumbent, senses ) );
+
+    CP::ParetoFront<std::vector<double>> front(schedule);
+    assert( front.add( incumbent, values ) );
+    assert( front.add( {4, -1}, {2, 1} ) );
+    assert( !front.add( {4, -2}, {2, 2} ) );
+    assert( !front.add( {4, -1}, {2, 1} ) );
+    assert( front.add( {2, -1}, {1, 1} ) );
+    assert( front.size() == 1 && front.getEntries().front().solution[1] == 1.0 );
+  }
+
+  {
+    CP::GeneratorParameters parameters;
+    parameters.processes = 3;
+    parameters.seed = 42;
+    CP::Model generated1, generated2, generated3;
+    CP::generateSchedulingModel(generated1, parameters);
+    CP::generateSchedulingModel(generated2, parameters);
+    parameters.seed = 43;
+    CP::generateSchedulingModel(generated3, parameters);
+    assert( generated1.stringify() == generated2.stringify() );
+    assert( generated1.stringify() != generated3.stringify() );
+    assert( generated1.getSequences().size() == 3 );
+    assert( generated1.getConstraints().size() == 3 * ( 9 * 2 + 2 * 2 ) );
+    assert( generated1.getLinearConstraints().size() == 3 );
+    assert( generated1.getObjectiveSense() == CP::Model::ObjectiveSense::MINIMIZE );
+    assert( generated1.getIndexedVariables().front().stringify().starts_with("p0_duration := { p0_duration[0] := n_ary_if( p0_mode == 1.00, ") );
+
+    CP::Tape tape(generated1);
+    tape.bounds();
+    assert( tape.getBounds(0).lowerBound == 0.0 && tape.getBounds(0).upperBound <= 110.0 );
+  }
+
+
+  {
+    // hot paths must not allocate once their buffers have been used
+    CP::Model generated;
+    CP::GeneratorParameters parameters;
+    parameters.processes = 2;
+    CP::generateSchedulingModel(generated, parameters);
+    auto& x = generated.addIntegerVariable("x");
+    auto& y = generated.addIntegerVariable("y");
+    generated.addTable( {x, y}, { {1, 2}, {2, 3}, {3, 1} }, CP::Table::Type::ALLOWED );
+
+    CP::Tape tape(generated);
+    std::vector<double> inputs(tape.getInputs().size(), 1.0);
+    std::vector<double> weights(tape.getOutputs().size(), 1.0);
+    std::vector<double> gradient;
+    tape.forward(inputs);
+    tape.gradient(weights, gradient);
+
+    CP::LinearEvaluator evaluator(generated);
+    std::vector<double> values(evaluator.getVariables().size(), 1.0);
+    evaluator.initialize(values);
+    std::vector<CP::Interval> bounds;
+    for ( auto variable : evaluator.getVariables() ) {
+      bounds.push_back({ variable->lowerBound, variable->upperBound });
+    }
+    auto initialBounds = bounds;
+    std::vector<double> deltas;
+    evaluator.penaltyDelta(0, 0.0, deltas);
+    evaluator.propagate(bounds);
+    auto& table = generated.getTables().front();
+
+    CP::AllocationScope scope;
+    for ( size_t i = 0; i < 10; i++ ) {
+      inputs[i % inputs.size()] = (double)i;
+      tape.forward(inputs);
+      tape.gradient(weights, gradient);
+      evaluator.set(i % values.size(), (double)( i % 2 ));
+      evaluator.delta(0, 1.0);
+      evaluator.penaltyDelta(0, 1.0, deltas);
+      bounds = initialBounds;
+      evaluator.propagate(bounds);
+      table.contains( [i](size_t column) { return column ? 2.0 : (double)i; } );
+    }
+    assert( scope.allocations() == 0 );
+
+    CP::CountingResource resource;
+    std::pmr::vector<double> buffer(&resource);
+    buffer.resize(100);
+    assert( resource.allocations() == 1 && resource.liveBytes() == 100 * sizeof(double) );
+    buffer = std::pmr::vector<double>(&resource);
+    assert( resource.liveBytes() == 0 );
+  }
+
+  {
+    CP::Model model;
+    auto& x = model.addIntegerVariable("x");
+    auto& y = model.addBinaryVariable("y");
+    auto& z = model.addVariable(CP::Variable::Type::REAL, "z", CP::max(x, 2 * x));
+    model.addSequence("s", 3);
+    model.addConstraint( z + y <= 5 );
+    model.addConstraint( (2 * x) >= z );
+    model.addConstraint( !y );
+    model.setObjective( z );
+    auto statistics = model.statistics();
+    assert( statistics.variables[0] == 1 && statistics.variables[1] == 4 && statistics.variables[2] == 1 );
+    assert( statistics.deducedVariables == 1 && statistics.sequences == 1 && statistics.objectives == 0 );
+    assert( statistics.constraints.at("less_or_equal") == 1 && statistics.constraints.at("greater_or_equal") == 1 && statistics.constraints.at("logical_not") == 1 );
+    assert( statistics.customOperators.at("max") == 1 );
+    // z + y <= 5 and 2 * x >= z have two nodes each, !y has one, and max( x, 2 * x ) has two of which 2 * x is duplicated
+    assert( statistics.nodes == 7 && statistics.maxDepth == 2 );
+    assert( statistics.duplicatedNodes == 1 && statistics.distinctNodes == 6 );
+    assert( statistics.sharedReferences == 2 );
+    assert( statistics.nameBytes >= 6 * sizeof(std::string) && statistics.operandBytes > 0 && statistics.deducedBytes > 0 );
+    assert( statistics.json().starts_with("{ \"variables\": { \"boolean\": 1, \"integer\": 4, \"real\": 1, \"deduced\": 1 }, \"constraints\": { \"greater_or_equal\": 1, \"less_or_equal\": 1, \"logical_not\": 1 }") );
+  }
+
+  {
+    auto& instrumentation = CP::Instrumentation::get();
+    instrumentation.reset();
+    CP::Model generated;
+    CP::generateSchedulingModel(generated, CP::GeneratorParameters());
+    CP::Tape tape(generated);
+    tape.forward( std::vector<double>(tape.getInputs().size(), 1.0) );
+    tape.forward( std::vector<double>(tape.getInputs().size(), 2.0) );
+    assert( instrumentation.getCount(CP::Instrumentation::Counter::NODES) == 2 * tape.getNodes().size() );
+    assert( instrumentation.getCount(CP::Instrumentation::Counter::ALLOCATIONS) > 0 );
+    assert( instrumentation.getEvents().size() == 2 );
+    assert( std::string(instrumentation.getEvents().front().name) == "generateSchedulingModel" );
+    assert( instrumentation.chromeTrace().starts_with("{ \"traceEvents\": [\n  { \"name\": \"generateSchedulingModel\", \"ph\": \"X\"") );
+    assert( instrumentation.json().starts_with("{ \"counters\": { \"nodes\": ") );
+    assert( instrumentation.json().find("\"Tape::Tape\": { \"calls\": 1") != std::string::npos );
+  }
+
+  {
+    CP::Model generated;
+    CP::generateSchedulingModel(generated, CP::GeneratorParameters());
+    CP::Tape tape(generated);
+    for ( size_t trial = 0; trial < 5; trial++ ) {
+      std::vector<double> inputs;
+      for ( size_t i = 0; i < tape.getInputs().size(); i++ ) {
+        inputs.push_back( (double)( ( i * 7 + trial * 3 ) % 5 ) );
+      }
+      tape.forward(inputs);
+      std::vector<double> expected;
+      for ( size_t output = 0; output < tape.getOutputs().size(); output++ ) {
+        expected.push_back( tape.getValue(output) );
+      }
+      tape.setInputs(inputs);
+      for ( size_t output = tape.getOutputs().size(); output-- > 0; ) {
+        assert( tape.evaluate(output) == expected[output] );
+      }
+    }
+    assert( tape.getShortCircuits() > 0 );
+
+    CP::Model model;
+    auto& x = model.addIntegerVariable("x");
+    auto& y = model.addIntegerVariable("y");
+    model.addConstraint( ( x >= 1 ).implies( y >= 2 ) );
+    model.addConstraint( x + y <= 4 );
+    model.addConstraint( CP::linear({1, -1}, {x, y}) <= 0 );
+    CP::FeasibilityChecker checker(model);
+    assert( checker.size() == 3 && checker.stringify(2) == "1.00 * x + -1.00 * y <= 0.00" );
+    std::vector<double> values(2);
+    size_t ix = checker.getTape().getInputIndex(x).value(), iy = checker.getTape().getInputIndex(y).value();
+    checker.setProfiling(true);
+    values[ix] = 0; values[iy] = 1;
+    assert( checker.isFeasible(values) );
+    values[ix] = 1; values[iy] = 1;
+    assert( !checker.isFeasible(values) );
+    values[ix] = 3; values[iy] = 2;
+    auto violations = checker.violations(values);
+    assert( violations.size() == 2 && violations[0].first == 1 && violations[0].second == 1.0 && violations[1].first == 2 && violations[1].second == 1.0 );
+    auto& profiles = checker.getProfiles();
+    assert( profiles[0].evaluations == 3 && profiles[0].violations == 1 && profiles[0].shortCircuits == 1 );
+    assert( profiles[1].evaluations == 2 && profiles[2].evaluations == 2 );
+    auto report = checker.report(5);
+    assert( std::ranges::count(report, '\n') == 3 );
+    assert( report.find("3 evaluations, 33.33 % violated, 33.33 % short-circuited: ( !( x >= 1.00 ) ) || ( y >= 2.00 )") != std::string::npos );
+  }
+
+  {
+    CP::Model model;
+    auto& x = model.addIntegerVariable("x");
+    auto& y = model.addIntegerVariable("y");
+    model.addConstraint( x >= 0 );
+    model.addConstraint( CP::max(x, y, x + y, x * y) <= 100 );
+    model.addConstraint( y <= 5 );
+    CP::FeasibilityChecker checker(model);
+    assert( checker.getCost(0) == 4 && checker.getCost(1) > checker.getCost(2) );
+    std::vector<double> values(2);
+    size_t iy = checker.getTape().getInputIndex(y).value();
+
+    // candidates with y > 5 are only rejected by the last constraint
+    checker.setOrdering(CP::FeasibilityChecker::Ordering::MOVE_TO_FRONT);
+    values[iy] = 6;
+    assert( checker.findViolation(values) == 2 );
+    assert( checker.getOrder() == std::vector<size_t>({2, 0, 1}) );
+    values[iy] = 1;
+    assert( checker.isFeasible(values) );
+    assert( checker.getOrder() == std::vector<size_t>({2, 0, 1}) );
+
+    CP::FeasibilityChecker rate(model);
+    rate.setOrdering(CP::FeasibilityChecker::Ordering::REJECTION_RATE);
+    rate.setProfiling(true);
+    values[iy] = 200;
+    assert( rate.findViolation(values) == 1 );
+    assert( rate.getOrder() == std::vector<size_t>({1, 0, 2}) );
+    // the cheaper constraint overtakes the more expensive one once it rejects as often
+    assert( rate.findViolation(values) == 1 );
+    values[iy] = 6;
+    assert( rate.findViolation(values) == 2 );
+    assert( rate.getOrder() == std::vector<size_t>({2, 1, 0}) );
+    assert( rate.findViolation(values) == 2 );
+    values[iy] = 200;
+    assert( rate.findViolation(values) == 2 );
+    assert( rate.getProfiles()[1].evaluations == 3 && rate.getProfiles()[2].evaluations == 3 );
+    // full reports are independent of the order
+    assert( rate.violations(values).size() == 2 && rate.violations(values).front().first == 1 );
+  }
+
+  {
+    CP::Model generated;
+    CP::GeneratorParameters parameters;
+    parameters.processes = 20;
+    CP::generateSchedulingModel(generated, parameters);
+    CP::FeasibilityChecker checker(generated);
+    CP::ThreadPool pool(4);
+    assert( pool.size() == 4 );
+    for ( size_t trial = 0; trial < 3; trial++ ) {
+      std::vector<double> values;
+      for ( size_t i = 0; i < checker.getInputs().size(); i++ ) {
+        values.push_back( (double)( ( i * 5 + trial ) % 7 ) );
+      }
+      auto expected = checker.violations(values);
+      assert( !expected.empty() );
+      assert( checker.violations(values, pool) == expected );
+    }
+
+    std::vector<size_t> squares(100);
+    pool.run( squares.size(), [&](size_t task) { squares[task] = task * task; } );
+    assert( squares[99] == 99 * 99 );
+    bool thrown = false;
+    try {
+      pool.run( 10, [](size_t task) { if ( task == 3 ) throw std::runtime_error("task"); } );
+    }
+    catch ( const std::runtime_error& ) {
+      thrown = true;
+    }
+    assert( thrown );
+  }
+
+  {
+    CP::Model model;
+    auto& x = model.addVariable(CP::Variable::Type::INTEGER, "x", 0, 10);
+    auto& y = model.addVariable(CP::Variable::Type::INTEGER, "y", 0, 10);
+    auto& b = model.addBinaryVariable("b");
+    model.addConstraint( y <= 8 );
+    model.addConstraint( b.implies( x >= 5 ) );
+    model.addConstraint( x * 2 <= 20 );
+    model.addConstraint( x + y <= 4 );
+    model.addConstraint( b == 1 );
+    model.addConstraint( CP::max(x, y) <= 9 );
+
+    CP::ConflictAnalyzer analyzer(model);
+    assert( analyzer.isInfeasible({1, 3, 4}) );
+    assert( !analyzer.isInfeasible({0, 1, 2, 3, 5}) );
+    auto conflict = analyzer.quickXplain();
+    assert( conflict == std::vector<size_t>({1, 3, 4}) );
+    assert( analyzer.stringify(conflict) == "( !b ) || ( x >= 5.00 )\nx + y <= 4.00\nb == 1.00\n" );
+    CP::ThreadPool pool(3);
+    assert( analyzer.deletionFilter(pool) == conflict );
+
+    // tables and linear constraints
+    CP::Model tabled;
+    auto& u = tabled.addVariable(CP::Variable::Type::INTEGER, "u", 0, 10);
+    auto& v = tabled.addVariable(CP::Variable::Type::INTEGER, "v", 0, 10);
+    tabled.addConstraint( u >= 0 );
+    tabled.addTable( {u, v}, { {1, 1}, {2, 2} } );
+    tabled.addConstraint( CP::linear({1, -1}, {u, v}) >= 1 );
+    CP::ConflictAnalyzer tableAnalyzer(tabled);
+    assert( tableAnalyzer.quickXplain() == std::vector<size_t>({1, 2}) );
+    assert( tableAnalyzer.deletionFilter(pool) == std::vector<size_t>({1, 2}) );
+
+    // no conflict is reported for models which are not proven infeasible
+    CP::Model feasible;
+    auto& w = feasible.addVariable(CP::Variable::Type::REAL, "w", 0, 10);
+    feasible.addConstraint( w <= 5 );
+    CP::ConflictAnalyzer feasibleAnalyzer(feasible);
+    assert( feasibleAnalyzer.quickXplain().empty() && feasibleAnalyzer.deletionFilter(pool).empty() );
+  }
+
+  {
+    CP::Model model;
+    auto& x = model.addVariable(CP::Variable::Type::INTEGER, "x", 0, 10);
+    model.addConstraint( x >= 5 );
+    model.addConstraint( x <= 3 );
+    CP::FeasibilityRepair repair(model);
+    repair.setWeight(0, 10);
+    repair.setWeight(x, 5, 5);
+    auto relaxations = repair.repair();
+    assert( repair.isMinimal() && relaxations.size() == 1 );
+    assert( relaxations[0].type == CP::FeasibilityRepair::Relaxation::Type::CONSTRAINT && relaxations[0].index == 1 );
+    assert( repair.stringify(relaxations[0]) == "relax constraint x <= 3.00 [ weight 1.00 ]" );
+    // after a change of the weights the cheaper relaxation is chosen
+    repair.setWeight(1, 20);
+    relaxations = repair.repair();
+    assert( relaxations.size() == 1 && relaxations[0].index == 0 && CP::FeasibilityRepair::getWeight(relaxations) == 10.0 );
+    // without time, the previous plan is cheaper than relaxing all items
+    relaxations = repair.repair( std::chrono::seconds(-1) );
+    assert( relaxations.size() == 1 && relaxations[0].index == 0 && repair.isMinimal() );
+
+    CP::Model bounded;
+    auto& y = bounded.addVariable(CP::Variable::Type::INTEGER, "y", 6, 10);
+    bounded.addConstraint( y <= 3 );
+    CP::FeasibilityRepair boundRepair(bounded);
+    boundRepair.setWeight(0, 10);
+    relaxations = boundRepair.repair();
+    assert( relaxations.size() == 1 && relaxations[0].type == CP::FeasibilityRepair::Relaxation::Type::LOWER_BOUND );
+    assert( boundRepair.stringify(relaxations[0]) == "relax y >= 6.00 [ weight 1.00 ]" );
+    // without time, all items remain relaxed
+    CP::FeasibilityRepair timedRepair(bounded);
+    assert( timedRepair.repair( std::chrono::seconds(-1) ).size() == 3 && !timedRepair.isMinimal() );
+
+    CP::Model feasible;
+    auto& z = feasible.addVariable(CP::Variable::Type::REAL, "z", 0, 10);
+    feasible.addConstraint( z <= 3 );
+    CP::FeasibilityRepair feasibleRepair(feasible);
+    assert( feasibleRepair.repair().empty() && feasibleRepair.isMinimal() );
+  }
+
+  {
+    CP::Model model;
+    auto& b = model.addBinaryVariable("b");
+    auto& x = model.addIntegerVariable("x");
+    model.addConstraint( b.implies( x >= 5 ) );
+    model.addConstraint( CP::if_then_else(b, x, 2 * x) <= 6 );
+    model.addConstraint( CP::n_ary_if({ {x == 1, 3}, {b, 4} }, 5) >= 4 );
+    model.addConstraint( x <= 10 );
+
+    CP::Specializer specializer(model);
+    assert( &specializer.getConstraint(3) == &model.getConstraints().back() );
+    specializer.fix(b, 1);
+    assert( specializer.getConstraint(0).stringify() == "x >= 5.00" );
+    assert( specializer.getConstraint(1).stringify() == "x <= 6.00" );
+    assert( specializer.getConstraint(2).stringify() == "n_ary_if( x == 1.00, 3.00, 4.00 ) >= 4.00" );
+    assert( &specializer.getConstraint(3) == &model.getConstraints().back() );
+    assert( specializer.getSpecializations() == 3 );
+    specializer.getConstraint(0);
+    specializer.fix(b, 1);
+    assert( specializer.getSpecializations() == 3 );
+
+    specializer.fix(b, 0);
+    assert( specializer.isRedundant(0) && !specializer.isViolated(0) );
+    assert( specializer.getConstraint(1).stringify() == "2.00 * x <= 6.00" );
+    assert( specializer.getConstraint(2).stringify() == "n_ary_if( x == 1.00, 3.00, 5.00 ) >= 4.00" );
+    specializer.fix(x, 1);
+    assert( specializer.isViolated(2) && specializer.isRedundant(3) );
+    specializer.release(x);
+    specializer.release(b);
+    assert( specializer.getConstraint(0).stringify() == model.getConstraints().front().stringify() );
+  }
+
+  {
+    CP::Model model;
+    auto& load = model.addIndexedVariables(CP::Variable::Type::INTEGER, "load");
+    for ( size_t i = 0; i < 3; i++ ) {
+      load.emplace_back(0, 10);
+    }
+    auto& x = model.addIntegerVariable("x");
+    model.addConstraint( load[0] + load[1] + load[2] <= x );
+    model.addConstraint( x <= 20 );
+
+    CP::SymmetryDetector detector(model);
+    assert( detector.getGenerators().size() == 2 );
+    auto orbits = detector.getOrbits();
+    assert( orbits.size() == 1 && orbits[0].size() == 3 );
+    assert( std::ranges::find(orbits[0], &x) == orbits[0].end() );
+    assert( detector.addSymmetryBreakingConstraints(model) == 2 );
+    assert( model.getConstraints().back().stringify() == "load[0] <= load[2]" );
+    // the symmetry of the remaining variables is broken by a second pass
+    CP::SymmetryDetector remaining(model);
+    assert( remaining.getGenerators().size() == 1 && remaining.getGenerators()[0].size() == 2 );
+    remaining.addSymmetryBreakingConstraints(model);
+    assert( model.getConstraints().back().stringify() == "load[1] <= load[2]" );
+    assert( CP::SymmetryDetector(model).getGenerators().empty() );
+  }
+
+  {
+    // machines with a start and a duration are interchangeable unless their durations differ
+    for ( double minDuration : { 2.0, 3.0 } ) {
+      CP::Model model;
+      auto& start = model.addIndexedVariables(CP::Variable::Type::INTEGER, "start");
+      auto& duration = model.addIndexedVariables(CP::Variable::Type::INTEGER, "duration");
+      for ( size_t i = 0; i < 2; i++ ) {
+        start.emplace_back(0, 10);
+        duration.emplace_back(1, 5);
+        model.addConstraint( start[i] + duration[i] <= 10 );
+      }
+      model.addConstraint( duration[0] >= 2 );
+      model.addConstraint( duration[1] >= minDuration );
+      CP::SymmetryDetector detector(model);
+      if ( minDuration == 2.0 ) {
+        assert( detector.getGenerators().size() == 1 && detector.getGenerators()[0].size() == 4 );
+        assert( detector.getOrbits().size() == 2 );
+      }
+      else {
+        assert( detector.getGenerators().empty() && detector.getOrbits().empty() );
+      }
+    }
+
+    CP::Model model;
+    model.addSequence("sequence", 3);
+    assert( CP::SymmetryDetector(model).getOrbits().size() == 1 );
+
+    // tables differing beyond the printed precision are not interchangeable
+    CP::Model tables;
+    auto& x = tables.addRealVariable("x");
+    auto& y = tables.addRealVariable("y");
+    tables.addTable( {x}, { {1.004} } );
+    tables.addTable( {y}, { {1.001} } );
+    assert( CP::SymmetryDetector(tables).getGenerators().empty() );
+    CP::Model equalTables;
+    auto& u = equalTables.addRealVariable("u");
+    auto& v = equalTables.addRealVariable("v");
+    equalTables.addTable( {u}, { {1.004} } );
+    equalTables.addTable( {v}, { {1.004} } );
+    assert( CP::SymmetryDetector(equalTables).getGenerators().size() == 1 );
+  }
+
+  {
+    CP::Model model;
+    auto& x = model.addVariable(CP::Variable::Type::INTEGER, "x", 0, 10);
+    auto& y = model.addBinaryVariable("y");
+    auto& z = model.addBinaryVariable("z");
+    auto& w = model.addBinaryVariable("w");
+    model.addConstraint( y.implies( x >= 4 ) );
+    model.addConstraint( z.implies( y == 1 ) );
+    model.addConstraint( w.implies( x >= 20 ) );
+    model.addConstraint( x <= 10 * y );
+
+    CP::ThreadPool pool(2);
+    CP::Prober prober(model);
+    assert( prober.probe(pool) && prober.isComplete() );
+    // w = 1 is infeasible
+    assert( prober.getBounds(w).lowerBound == 0.0 && prober.getBounds(w).upperBound == 0.0 );
+    assert( prober.getImplications(w, false).empty() );
+    // y = 0 implies x = 0 and z = 0, y = 1 implies x >= 4
+    assert( prober.getImpliedBounds(x, y, false).upperBound == 0.0 );
+    assert( prober.getImpliedBounds(z, y, false).upperBound == 0.0 );
+    assert( prober.getImpliedBounds(x, y, true).lowerBound == 4.0 );
+    assert( prober.getImpliedBounds(x, z, true).lowerBound == 4.0 );
+    // z = 0 implies nothing
+    assert( prober.getImplications(z, false).empty() );
+    assert( prober.getImpliedBounds(x, z, false).lowerBound == 0.0 );
+
+    auto index = [&](const CP::Variable& variable) { return (size_t)( std::ranges::find(prober.getInputs(), &variable) - prober.getInputs().begin() ); };
+    auto bounds = prober.getBounds();
+    bounds[index(z)] = { 1.0, 1.0 };
+    assert( prober.propagate(bounds) );
+    assert( bounds[index(x)].lowerBound == 4.0 && bounds[index(y)].lowerBound == 1.0 );
+    bounds[index(x)].upperBound = 3.0;
+    assert( !prober.propagate(bounds) );
+
+    model.addConstraint( x <= 2 );
+    model.addConstraint( z == 1 );
+    CP::Prober infeasible(model);
+    assert( !infeasible.probe(pool) );
+  }
+
+  {
+    std::vector<size_t> lubySequence;
+    for ( size_t i = 1; i <= 15; i++ ) {
+      lubySequence.push_back(CP::luby(i));
+    }
+    assert( lubySequence == std::vector<size_t>({ 1, 1, 2, 1, 1, 2, 4, 1, 1, 2, 1, 1, 2, 4, 8 }) );
+
+    // queens
+    for ( auto restarts : { CP::Search::Restarts::NONE, CP::Search::Restarts::LUBY, CP::Search::Restarts::GEOMETRIC } ) {
+      CP::Model model;
+      auto& queens = model.addIndexedVariables(CP::Variable::Type::INTEGER, "queen");
+      for ( size_t i = 0; i < 6; i++ ) {
+        queens.emplace_back(1, 6);
+      }
+      for ( size_t i = 0; i < 6; i++ ) {
+        for ( size_t j = i + 1; j < 6; j++ ) {
+          model.addConstraint( queens[i] != queens[j] );
+          model.addConstraint( queens[i] - queens[j] != (double)(j - i) );
+          model.addConstraint( queens[j] - queens[i] != (double)(j - i) );
+        }
+      }
+      CP::Search search(model);
+      search.setRestarts(restarts, 2);
+      search.setSeed(42);
+      auto solution = search.solve();
+      assert( solution && !search.isComplete() );
+      CP::FeasibilityChecker checker(model);
+      assert( checker.getInputs() == search.getInputs() && checker.isFeasible(*solution) );
+      assert( restarts == CP::Search::Restarts::NONE || search.getStatistics().restarts > 0 );
+    }
+
+    // pigeonhole
+    for ( auto restarts : { CP::Search::Restarts::NONE, CP::Search::Restarts::GEOMETRIC } ) {
+      CP::Model model;
+      auto& pigeons = model.addIndexedVariables(CP::Variable::Type::INTEGER, "pigeon");
+      for ( size_t i = 0; i < 5; i++ ) {
+        pigeons.emplace_back(1, 4);
+      }
+      for ( size_t i = 0; i < 5; i++ ) {
+        for ( size_t j = i + 1; j < 5; j++ ) {
+          model.addConstraint( pigeons[i] != pigeons[j] );
+        }
+      }
+      CP::Search search(model);
+      search.setRestarts(restarts, 1, 1.2);
+      assert( !search.solve() && search.isComplete() );
+      assert( ( restarts == CP::Search::Restarts::NONE ) == ( search.getNogoods().size() == 0 ) );
+    }
+
+    // optimization
+    CP::Model model(CP::Model::ObjectiveSense::MINIMIZE);
+    auto& x = model.addVariable(CP::Variable::Type::INTEGER, "x", 0, 10);
+    auto& y = model.addVariable(CP::Variable::Type::INTEGER, "y", 0, 10);
+    model.setObjective( 2 * x + y );
+    model.addConstraint( x + y >= 5 );
+    model.addConstraint( x >= 1 || y >= 7 );
+    CP::Search search(model);
+    search.setRestarts(CP::Search::Restarts::LUBY, 1);
+    auto solution = search.solve();
+    assert( solution && search.isComplete() && search.getStatistics().solutions >= 1 );
+    assert( 2 * (*solution)[0] + (*solution)[1] == 6.0 );
+
+    // sequences
+    CP::Model sequenceModel;
+    auto sequence = sequenceModel.addSequence("s", 3);
+    sequenceModel.addConstraint( sequence[0] == 3 );
+    CP::Search sequenceSearch(sequenceModel);
+    auto permutation = sequenceSearch.solve();
+    assert( permutation && sequenceSearch.getInputs().size() == 3 );
+    auto sorted = *permutation;
+    std::sort(sorted.begin(), sorted.end());
+    assert( sorted == std::vector<double>({ 1, 2, 3 }) && (*permutation)[0] == 3.0 );
+  }
+
+  {
+    // user-defined heuristic branching on the largest value first
+    struct LargestValue : CP::FirstFail {
+      CP::Literal decide(size_t input, const std::vector<CP::Interval>& bounds) override { return { input, false, bounds[input].upperBound }; };
+    };
+
+    auto queens = [](CP::Model& model, size_t n) {
+      auto& queen = model.addIndexedVariables(CP::Variable::Type::INTEGER, "queen");
+      for ( size_t i = 0; i < n; i++ ) {
+        queen.emplace_back(1, n);
+      }
+      for ( size_t i = 0; i < n; i++ ) {
+        for ( size_t j = i + 1; j < n; j++ ) {
+          model.addConstraint( queen[i] != queen[j] );
+          model.addConstraint( queen[i] - queen[j] != (double)(j - i) );
+          model.addConstraint( queen[j] - queen[i] != (double)(j - i) );
+        }
+      }
+    };
+    CP::Model model;
+    queens(model, 6);
+    CP::FeasibilityChecker checker(model);
+    std::vector< std::unique_ptr<CP::Heuristic> > heuristics;
+    heuristics.push_back(std::make_unique<CP::FirstFail>());
+    heuristics.push_back(std::make_unique<CP::DomWdeg>());
+    heuristics.push_back(std::make_unique<CP::ActivityBased>());
+    heuristics.push_back(std::make_unique<CP::ImpactBased>());
+    heuristics.push_back(std::make_unique<CP::EarliestPosition>());
+    heuristics.push_back(std::make_unique<LargestValue>());
+    for ( auto& heuristic : heuristics ) {
+      CP::Search search(model);
+      search.setHeuristic(std::move(heuristic));
+      auto solution = search.solve();
+      assert( solution && checker.isFeasible(*solution) );
+    }
+    assert( CP::Search(model).getScope(0).size() == 2 );
+
+    // scores are updated by the events of an infeasible search
+    CP::Model pigeonhole;
+    auto& pigeon = pigeonhole.addIndexedVariables(CP::Variable::Type::INTEGER, "pigeon");
+    for ( size_t i = 0; i < 4; i++ ) {
+      pigeon.emplace_back(1, 3);
+    }
+    for ( size_t i = 0; i < 4; i++ ) {
+      for ( size_t j = i + 1; j < 4; j++ ) {
+        pigeonhole.addConstraint( pigeon[i] != pigeon[j] );
+      }
+    }
+    CP::Search search(pigeonhole);
+    search.setHeuristic(std::make_unique<CP::DomWdeg>());
+    assert( !search.solve() && search.isComplete() );
+    auto& domWdeg = static_cast<CP::DomWdeg&>(search.getHeuristic());
+    assert( domWdeg.getWeightedDegree(0) > 3.0 );
+
+    // x + y == 5, y + z == 5, x + z == 7 has no integer solution, but propagation narrows after each decision
+    CP::Model parity;
+    auto& x = parity.addVariable(CP::Variable::Type::INTEGER, "x", 0, 5);
+    auto& y = parity.addVariable(CP::Variable::Type::INTEGER, "y", 0, 5);
+    auto& z = parity.addVariable(CP::Variable::Type::INTEGER, "z", 0, 5);
+    parity.addConstraint( x + y == 5 );
+    parity.addConstraint( y + z == 5 );
+    parity.addConstraint( x + z == 7 );
+    search = CP::Search(parity);
+    search.setHeuristic(std::make_unique<CP::ActivityBased>());
+    assert( !search.solve() && search.isComplete() );
+    auto& activity = static_cast<CP::ActivityBased&>(search.getHeuristic());
+    assert( activity.getActivity(0) + activity.getActivity(1) + activity.getActivity(2) > 0.0 );
+    search = CP::Search(parity);
+    search.setHeuristic(std::make_unique<CP::ImpactBased>());
+    assert( !search.solve() && search.isComplete() );
+    auto& impact = static_cast<CP::ImpactBased&>(search.getHeuristic());
+    assert( impact.getImpact(0) + impact.getImpact(1) + impact.getImpact(2) > 0.0 );
+
+    // the earliest position is assigned to the first variable which can take it
+    CP::Model sequenceModel;
+    auto sequence = sequenceModel.addSequence("s", 4);
+    sequenceModel.addConstraint( sequence[0] >= 2 );
+    CP::Search sequenceSearch(sequenceModel);
+    sequenceSearch.setHeuristic(std::make_unique<CP::EarliestPosition>());
+    assert( sequenceSearch.solve() == std::vector<double>({ 2, 1, 3, 4 }) );
+  }
+
+  {
+    CP::IncumbentChannel channel(3, 2);
+    CP::IncumbentChannel::Incumbent incumbent;
+    assert( !channel.read(incumbent) && channel.getVersion() == 0 );
+    std::vector<double> values = { 1, 2, 3 };
+    assert( channel.publish(values, 6, 0) && values.size() == 3 );
+    {
+      CP::AllocationScope scope;
+      values.assign({ 0, 2, 3 });
+      assert( channel.publish(values, 5, 0) );
+      assert( scope.allocations() == 0 );
+    }
+    assert( channel.read(incumbent) && incumbent.values == std::vector<double>({ 0, 2, 3 }) && incumbent.objective == 5 && incumbent.version == 2 );
+    assert( !channel.read(incumbent) );
+
+    // consumers read consistent incumbents while the producer publishes
+    std::atomic<bool> done = false;
+    std::vector<std::thread> consumers;
+    std::atomic<size_t> inconsistent = 0;
+    for ( size_t i = 0; i < 2; i++ ) {
+      consumers.emplace_back( [&]() {
+        CP::IncumbentChannel::Incumbent latest;
+        latest.version = 2;
+        while ( !done.load() ) {
+          uint64_t previous = latest.version;
+          if ( channel.read(latest) ) {
+            bool consistent = latest.version > previous && latest.objective == latest.values[0] && latest.values[0] == latest.values[1] && latest.values[1] == latest.values[2];
+            inconsistent += !consistent;
+          }
+        }
+      } );
+    }
+    for ( double value = 1; value <= 2000; value++ ) {
+      values.assign(3, value);
+      assert( channel.publish(values, value, 0) );
+    }
+    done = true;
+    for ( auto& consumer : consumers ) {
+      consumer.join();
+    }
+    assert( inconsistent == 0 && channel.getVersion() == 2002 );
+
+    // the search publishes improving solutions and the optimal solution
+    CP::Model model(CP::Model::ObjectiveSense::MAXIMIZE);
+    auto& x = model.addVariable(CP::Variable::Type::INTEGER, "x", 0, 10);
+    auto& y = model.addVariable(CP::Variable::Type::INTEGER, "y", 0, 10);
+    model.setObjective( x + 2 * y );
+    model.addConstraint( x + y <= 8 );
+    CP::Search search(model);
+    CP::IncumbentChannel incumbents(search.getInputs().size());
+    search.setChannel(&incumbents);
+    auto solution = search.solve();
+    assert( solution && search.isComplete() && incumbents.getVersion() >= 2 );
+    CP::IncumbentChannel::Incumbent optimum;
+    assert( incumbents.read(optimum) && optimum.values == *solution && optimum.objective == 16 && optimum.bound == 16 );
+    assert( search.getStatistics().failedPublications == 0 );
+  }
+
+  {
+    // knapsack requiring several slices per worker
+    auto knapsack = [](CP::Model& model) {
+      auto& item = model.addIndexedVariables(CP::Variable::Type::INTEGER, "item");
+      std::vector<double> weights = { 7, 5, 9, 4, 8, 6, 3, 11 };
+      std::vector<double> profits = { 9, 6, 11, 5, 10, 8, 3, 14 };
+      CP::Expression weight(0.0), profit(0.0);
+      for ( size_t i = 0; i < weights.size(); i++ ) {
+        item.emplace_back(0, 3);
+        weight = weight + weights[i] * item[i];
+        profit = profit + profits[i] * item[i];
+      }
+      model.addConstraint( weight <= 40 );
+      model.setObjective( profit );
+    };
+    CP::Model model(CP::Model::ObjectiveSense::MAXIMIZE);
+    knapsack(model);
+    CP::FeasibilityChecker checker(model);
+
+    // deterministic runs with the same seed and number of threads are identical
+    std::vector< std::vector<double> > solutions;
+    std::vector<size_t> nodes;
+    for ( size_t run = 0; run < 2; run++ ) {
+      CP::ThreadPool pool(3);
+      CP::Portfolio portfolio(model, pool, 7);
+      portfolio.setMode(CP::Portfolio::Mode::DETERMINISTIC, 20);
+      auto solution = portfolio.solve(std::chrono::seconds(60), 300);
+      assert( solution && checker.isFeasible(*solution) && portfolio.getStatistics().slices >= 6 );
+      solutions.push_back(*solution);
+      nodes.push_back(portfolio.getStatistics().nodes);
+    }
+    assert( solutions[0] == solutions[1] && nodes[0] == nodes[1] );
+
+    // both modes find the optimum
+    CP::ThreadPool pool(2);
+    CP::Search search(model);
+    auto optimum = search.solve();
+    assert( optimum && search.isComplete() );
+    for ( auto mode : { CP::Portfolio::Mode::DETERMINISTIC, CP::Portfolio::Mode::NONDETERMINISTIC } ) {
+      CP::Portfolio portfolio(model, pool);
+      portfolio.setMode(mode, 50);
+      auto solution = portfolio.solve();
+      assert( solution && portfolio.isComplete() && checker.isFeasible(*solution) );
+      assert( portfolio.getSearch(0).getBestObjective() == search.getBestObjective() );
+    }
+
+    // probing a limited number of inputs is reproducible for any number of threads
+    CP::Model binary;
+    auto& b = binary.addIndexedVariables(CP::Variable::Type::BOOLEAN, "b");
+    for ( size_t i = 0; i < 6; i++ ) {
+      b.emplace_back();
+    }
+    for ( size_t i = 0; i + 1 < 6; i++ ) {
+      binary.addConstraint( b[i] + b[i + 1] <= 1 );
+    }
+    binary.addConstraint( b[0] + b[5] >= 1 );
+    CP::ThreadPool single(1);
+    CP::Prober first(binary), second(binary);
+    assert( first.probe(single, std::chrono::seconds(60), 2) && second.probe(pool, std::chrono::seconds(60), 2) );
+    assert( !first.isComplete() && first.getBounds().size() == second.getBounds().size() );
+    for ( size_t input = 0; input < first.getBounds().size(); input++ ) {
+      assert( first.getBounds()[input].lowerBound == second.getBounds()[input].lowerBound );
+      assert( first.getBounds()[input].upperBound == second.getBounds()[input].upperBound );
+    }
+  }
+
+  {
+    // nogoods with the largest LBD are deleted first
+    CP::NogoodDatabase database(2);
+    database.add({ { 0, true, 0 }, { 1, true, 0 } }, 3);
+    database.add({ { 0, false, 1 } }, 1);
+    database.add({ { 0, true, 0 }, { 1, false, 1 } });
+    assert( database.getLBD(2) == 2 && database.getLiteralCount() == 5 );
+    assert( database.reduce(2) == 1 && database.size() == 2 && database.getLiteralCount() == 3 );
+    assert( database.getLBD(0) == 1 && database.getLBD(1) == 2 );
+    std::vector<CP::Interval> bounds = { { 0, 1 }, { 0, 1 } };
+    std::vector<size_t> changed;
+    assert( database.propagate(bounds, changed) && bounds[0].upperBound == 0 && bounds[1].upperBound == 0 );
+    assert( database.getUses(0) == 1 && database.getUses(1) == 1 );
+
+    // recomputing the bounds of a branch does not change the search
+    CP::Model queens;
+    auto& queen = queens.addIndexedVariables(CP::Variable::Type::INTEGER, "queen");
+    for ( size_t i = 0; i < 8; i++ ) {
+      queen.emplace_back(1, 8);
+    }
+    for ( size_t i = 0; i < 8; i++ ) {
+      for ( size_t j = i + 1; j < 8; j++ ) {
+        queens.addConstraint( queen[i] != queen[j] );
+        queens.addConstraint( queen[i] - queen[j] != (double)(j - i) );
+        queens.addConstraint( queen[j] - queen[i] != (double)(j - i) );
+      }
+    }
+    CP::Search unlimited(queens);
+    CP::Search limited(queens);
+    limited.setMemoryLimits(2);
+    auto solution = unlimited.solve();
+    assert( solution && limited.solve() == solution );
+    assert( limited.getStatistics().nodes == unlimited.getStatistics().nodes );
+    assert( limited.getStatistics().recomputations > 0 && unlimited.getStatistics().recomputations == 0 );
+    assert( limited.getStatistics().peakBytes < unlimited.getStatistics().peakBytes );
+
+    // infeasibility is proven with a bounded number of nogoods
+    CP::Model pigeonhole;
+    auto& pigeon = pigeonhole.addIndexedVariables(CP::Variable::Type::INTEGER, "pigeon");
+    for ( size_t i = 0; i < 6; i++ ) {
+      pigeon.emplace_back(1, 5);
+    }
+    for ( size_t i = 0; i < 6; i++ ) {
+      for ( size_t j = i + 1; j < 6; j++ ) {
+        pigeonhole.addConstraint( pigeon[i] != pigeon[j] );
+      }
+    }
+    CP::Search search(pigeonhole);
+    search.setRestarts(CP::Search::Restarts::GEOMETRIC, 1, 1.2);
+    search.setMemoryLimits(2, 8);
+    assert( !search.solve() && search.isComplete() );
+    assert( search.getNogoods().size() <= 8 && search.getStatistics().deletedNogoods > 0 );
+  }
+
+  {
+    // non-overlap of activities is generated for the pairs overlapping in an assignment
+    CP::Model model(CP::Model::ObjectiveSense::MINIMIZE);
+    auto& start = model.addIndexedVariables(CP::Variable::Type::INTEGER, "start");
+    std::vector<double> duration = { 2, 3, 2, 3 };
+    std::vector<CP::Expression> ends;
+    for ( size_t i = 0; i < duration.size(); i++ ) {
+      start.emplace_back(0, 10);
+      ends.push_back( start[i] + duration[i] );
+    }
+    model.setObjective( CP::max(ends) );
+    auto nonOverlap = [&](size_t i, size_t j) {
+      return start[i] + duration[i] <= start[j] || start[j] + duration[j] <= start[i];
+    };
+    CP::LazyConstraints lazy;
+    lazy.addGenerator( [&](const CP::Assignment& assignment, std::vector<CP::Expression>& constraints) {
+      for ( size_t i = 0; i < duration.size(); i++ ) {
+        for ( size_t j = i + 1; j < duration.size(); j++ ) {
+          if ( assignment[start[i]] < assignment[start[j]] + duration[j] && assignment[start[j]] < assignment[start[i]] + duration[i] ) {
+            constraints.push_back( nonOverlap(i, j) );
+          }
+        }
+      }
+    } );
+
+    CP::Search search(model);
+    search.setLazyConstraints(&lazy);
+    auto solution = search.solve();
+    assert( solution && search.isComplete() && search.getBestObjective() == 10.0 );
+    assert( lazy.size() > 0 && lazy.size() <= 6 && search.getStatistics().lazyConstraints == lazy.size() );
+
+    // a subsequent search propagates the constraints generated before
+    CP::Search subsequent(model);
+    subsequent.setLazyConstraints(&lazy);
+    subsequent.setHeuristic(std::make_unique<CP::DomWdeg>());
+    assert( subsequent.solve() && subsequent.getBestObjective() == 10.0 && subsequent.getStatistics().lazyConstraints == lazy.size() );
+
+    // the schedule satisfies all pairs, and the generated constraints can be promoted into the model
+    CP::FeasibilityChecker unconstrained(model);
+    assert( lazy.isFeasible(unconstrained, *solution) );
+    std::vector<double> overlapping(duration.size(), 0.0);
+    size_t generated = lazy.size();
+    assert( !lazy.isFeasible(unconstrained, overlapping) && lazy.size() == generated );
+    assert( lazy.promote(model) == lazy.size() && model.getConstraints().size() == lazy.size() && lazy.promote(model) == 0 );
+    CP::FeasibilityChecker promoted(model);
+    assert( promoted.isFeasible(*solution) );
+
+    // cuts differing beyond the printed precision are distinct
+    CP::Model cuts;
+    auto& z = cuts.addRealVariable("z");
+    cuts.addConstraint( z >= 0 );
+    CP::FeasibilityChecker cutChecker(cuts);
+    CP::LazyConstraints bounds;
+    bounds.addGenerator( [&](const CP::Assignment& assignment, std::vector<CP::Expression>& constraints) {
+      for ( double bound : { 1.004, 1.001 } ) {
+        if ( assignment[z] > bound ) {
+          constraints.push_back( z <= bound );
+        }
+      }
+    } );
+    std::vector<double> value = { 2.0 };
+    assert( bounds.generate({ cutChecker.getTape(), value }).size() == 2 && bounds.size() == 2 );
+    assert( bounds.generate({ cutChecker.getTape(), value }).empty() && !bounds.isFeasible(cutChecker, value) );
+
+    // generators must only use inputs of the search
+    auto& unused = model.addVariable(CP::Variable::Type::INTEGER, "unused", 0, 1);
+    CP::Model other(CP::Model::ObjectiveSense::MINIMIZE);
+    auto& y = other.addVariable(CP::Variable::Type::INTEGER, "y", 0, 1);
+    other.setObjective( y );
+    CP::LazyConstraints invalid;
+    invalid.addGenerator( [&](const CP::Assignment&, std::vector<CP::Expression>& constraints) { constraints.push_back( unused >= 1 ); } );
+    CP::Search otherSearch(other);
+    otherSearch.setLazyConstraints(&invalid);
+    bool thrown = false;
+    try {
+      otherSearch.solve();
+    }
+    catch ( const std::invalid_argument& ) {
+      thrown = true;
+    }
+    assert( thrown );
+  }
+
+  {
+    // propagation narrowing large domains by one value per round stops at the time limit
+    CP::Model model;
+    auto& x = model.addVariable(CP::Variable::Type::INTEGER, "x", 0, 1e9);
+    auto& y = model.addVariable(CP::Variable::Type::INTEGER, "y", 0, 1e9);
+    model.addConstraint( x >= y + 1 );
+    model.addConstraint( y >= x + 1 );
+    CP::Search search(model);
+    auto start = std::chrono::steady_clock::now();
+    assert( !search.solve(std::chrono::milliseconds(200)) );
+    assert( std::chrono::steady_clock::now() - start < std::chrono::seconds(2) );
+  }
+
+  {
+    // both directions of an equality are revised until a fixpoint, which proves 2x + 2y = 5 infeasible
+    CP::Model parity;
+    auto& x = parity.addVariable(CP::Variable::Type::INTEGER, "x", 0, 10);
+    auto& y = parity.addVariable(CP::Variable::Type::INTEGER, "y", 0, 10);
+    parity.addConstraint( CP::linear( {2, 2}, {x, y} ) == 5 );
+    CP::LinearEvaluator evaluator(parity);
+    std::vector<CP::Interval> bounds = { {0, 10}, {0, 10} };
+    assert( !evaluator.propagate(bounds) );
+
+    // terms of the same variable are merged
+    CP::Model duplicates;
+    auto& z = duplicates.addVariable(CP::Variable::Type::INTEGER, "z", 0, 10);
+    duplicates.addConstraint( CP::linear( {1, 1}, {z, z} ) <= 1 );
+    CP::LinearEvaluator merged(duplicates);
+    merged.initialize({ 0 });
+    assert( merged.delta(0, 1) == 1.0 && merged.penaltyDelta(0, 2)[0] == 3.0 );
+    merged.set(0, 1);
+    assert( merged.getLhs(0) == 2.0 && merged.getTotalViolation() == 1.0 );
+    std::vector<CP::Interval> zBounds = { {0, 10} };
+    assert( merged.propagate(zBounds) && zBounds[0].upperBound == 0.0 );
+  }
+
+  {
+    CP::Model huge;
+    auto& resource = huge.addVariable(CP::Variable::Type::INTEGER, "resource", 0, 1);
+    auto& activity = huge.addVariable(CP::Variable::Type::INTEGER, "activity", 0, 1e17);
+    double base = 9007199254740992.0;
+    auto& forbidden = huge.addTable( {resource, activity}, { {1, base}, {1, base + 2}, {1, base + 8}, {1, 1e17} }, CP::Table::Type::FORBIDDEN );
+    std::vector<CP::Interval> bounds = { {1, 1}, {base, base + 8} };
+    assert( forbidden.propagate(bounds) );
+    assert( bounds[1].lowerBound == base + 4 && bounds[1].upperBound == base + 6 );
+    bounds = { {1, 1}, {base, base + 2} };
+    assert( !forbidden.propagate(bounds) );
+    bounds = { {1, 1}, {0, 1e17} };
+    assert( forbidden.propagate(bounds) );
+    assert( bounds[1].lowerBound == 0 && bounds[1].upperBound == std::nextafter(1e17, 0.0) );
+  }
+
+  {
+    CP::Model model;
+    auto& b = model.addBinaryVariable("b");
+    auto& x = model.addIntegerVariable("x");
+    auto& d = model.addVariable(CP::Variable::Type::INTEGER, "d", CP::if_then_else(b, x, 2 * x));
+    auto& y = model.addIntegerVariable("y");
+    model.addConstraint( d <= 6 );
+    model.addConstraint( y <= 3 );
+
+    CP::Specializer specializer(model);
+    assert( &specializer.getConstraint(0) == &model.getConstraints().front() );
+    specializer.fix(y, 1);
+    assert( &specializer.getConstraint(0) == &model.getConstraints().front() );
+    assert( specializer.isRedundant(1) && specializer.getSpecializations() == 1 );
+    specializer.fix(b, 0);
+    assert( specializer.getConstraint(0).stringify() == "2.00 * x <= 6.00" );
+    specializer.fix(x, 4);
+    assert( specializer.isViolated(0) );
+    specializer.release(x);
+    specializer.release(b);
+    assert( &specializer.getConstraint(0) == &model.getConstraints().front() );
+    // deduced variables whose expressions use no fixed variable are kept
+    assert( CP::specialize( model.getConstraints().front(), { { &y, 2.0 } } ).stringify() == "d <= 6.00" );
+  }
+
+  {
+    // solutions tying on the first objective are compared by the second objective
+    CP::Model model(CP::Model::ObjectiveSense::MINIMIZE);
+    auto& v = model.addIndexedVariables(CP::Variable::Type::INTEGER, "v");
+    v.emplace_back(0, 3);
+    v.emplace_back(0, 3);
+    model.addConstraint( v[0] + v[1] >= 2 );
+    model.setObjective( v[0] );
+    model.addObjective( CP::Model::ObjectiveSense::MAXIMIZE, v[1] );
+    CP::Search search(model);
+    CP::IncumbentChannel incumbents(search.getInputs().size());
+    search.setChannel(&incumbents);
+    auto solution = search.solve();
+    assert( solution && search.isComplete() );
+    assert( search.getBestObjectives() == std::vector<double>({ 0, 3 }) );
+    auto input = std::ranges::find(search.getInputs(), &v[1]) - search.getInputs().begin();
+    assert( (*solution)[(size_t)input] == 3 );
+    CP::IncumbentChannel::Incumbent optimum;
+    assert( incumbents.read(optimum) && optimum.values == *solution );
+
+    CP::ThreadPool pool(2);
+    for ( auto mode : { CP::Portfolio::Mode::DETERMINISTIC, CP::Portfolio::Mode::NONDETERMINISTIC } ) {
+      CP::Portfolio portfolio(model, pool);
+      portfolio.setMode(mode, 2);
+      assert( portfolio.solve() == solution && portfolio.isComplete() );
+    }
+  }
+
+  {
+    // the compiled views evaluate fewer nodes than the constraints
+    CP::Model model;
+    auto& b = model.addBinaryVariable("b");
+    auto& x = model.addIntegerVariable("x");
+    auto& y = model.addIntegerVariable("y");
+    model.addConstraint( CP::if_then_else(b, x + 2 * y, x * y - y) <= 6 );
+    model.addConstraint( b.implies( x >= 1 ) );
+    CP::Tape original;
+    for ( auto& constraint : model.getConstraints() ) {
+      original.addViolation(constraint);
+    }
+    CP::Specializer specializer(model);
+    specializer.fix(b, 1);
+    auto tape = specializer.compile();
+    assert( tape.getOutputs().size() == 2 && tape.getInputs().size() == 2 );
+    assert( tape.getNodes().size() < original.getNodes().size() );
+    std::vector<double> values(2);
+    values[ tape.getInputIndex(x).value() ] = 0;
+    values[ tape.getInputIndex(y).value() ] = 4;
+    tape.forward(values);
+    assert( tape.getValue(0) == 2.0 && tape.getValue(1) == 1.0 );
+  }
 
 #ifdef USE_LIMEX
 
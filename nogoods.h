@@ -0,0 +1,250 @@
+ /**
+ ******************************************************************************
+ *
+ *  Nogood database with watched literals
+ *
+ ******************************************************************************
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <numeric>
+#include <optional>
+#include <vector>
+#include <stdexcept>
+
+#include "cp.h"
+
+namespace CP {
+
+/*******************************************
+ * Literal
+ ******************************************/
+
+/**
+ * @brief Represents a bound of an integer or boolean input, i.e. `input <= value` or `input >= value`.
+ */
+struct Literal {
+  size_t input;
+  bool upper; ///< True for `input <= value`, false for `input >= value`
+  double value;
+
+  /**
+   * @brief Returns true if the literal holds for all values within the bounds.
+   */
+  inline bool isTrue(const std::vector<Interval>& bounds) const {
+    return upper ? bounds[input].upperBound <= value : bounds[input].lowerBound >= value;
+  }
+
+  /**
+   * @brief Returns the negation of the literal for integer inputs.
+   */
+  inline Literal negation() const {
+    return upper ? Literal{ input, false, value + 1 } : Literal{ input, true, value - 1 };
+  }
+
+  /**
+   * @brief Narrows the bounds such that the literal holds and returns false if the bounds become empty.
+   */
+  inline bool apply(std::vector<Interval>& bounds) const {
+    auto& interval = bounds[input];
+    if ( upper ) {
+      interval.upperBound = std::min(interval.upperBound, value);
+    }
+    else {
+      interval.lowerBound = std::max(interval.lowerBound, value);
+    }
+    return interval.lowerBound <= interval.upperBound;
+  }
+};
+
+/*******************************************
+ * NogoodDatabase
+ ******************************************/
+
+/**
+ * @brief Stores nogoods, i.e. sets of literals which must not hold together, and propagates them using two watched literals.
+ *
+ * The first two literals of each nogood are watched and the nogood is only examined if the bounds of the input of a
+ * watched literal change. If a watched literal holds, another literal which does not hold is watched instead. If no such
+ * literal exists, the other watched literal is negated, or a conflict is reported if it holds, too. As the bounds only
+ * narrow along a branch of the search, the watches remain valid when the search backtracks, so that the database
+ * survives backtracking and restarts without any update.
+ *
+ * To bound the memory, reduce() deletes the nogoods with the largest literal block distance (LBD), i.e. the number of
+ * distinct decision levels of their literals, preferring nogoods which were used more often and more recently added.
+ */
+class NogoodDatabase {
+public:
+  inline NogoodDatabase(size_t inputs = 0) : watches(inputs) {};
+
+  inline size_t size() const { return nogoods.size(); };
+  inline const std::vector<Literal>& operator[](size_t nogood) const { return nogoods.at(nogood); };
+  inline size_t getLBD(size_t nogood) const { return lbds.at(nogood); };
+
+  /**
+   * @brief Returns the number of times a nogood narrowed the bounds or detected a conflict.
+   */
+  inline size_t getUses(size_t nogood) const { return uses.at(nogood); };
+
+  /**
+   * @brief Returns the total number of literals of all nogoods.
+   */
+  inline size_t getLiteralCount() const { return literalCount; };
+
+  /**
+   * @brief Adds a nogood, which is examined by the next call of propagate().
+   *
+   * @param lbd The number of distinct decision levels of the literals, by default the number of literals.
+   */
+  inline void add(std::vector<Literal> literals, std::optional<size_t> lbd = std::nullopt) {
+    if ( literals.empty() ) {
+      throw std::invalid_argument("CP: nogood requires at least one literal");
+    }
+    for ( auto& literal : literals ) {
+      if ( literal.input >= watches.size() ) {
+        throw std::invalid_argument("CP: literal of nogood refers to unknown input");
+      }
+    }
+    lbds.push_back(lbd.value_or(literals.size()));
+    uses.push_back(0);
+    literalCount += literals.size();
+    nogoods.push_back(std::move(literals));
+    pending.push_back(nogoods.size() - 1);
+  }
+
+  /**
+   * @brief Deletes all but the given number of nogoods and returns the number of deleted nogoods.
+   *
+   * The nogoods with the smallest LBD are kept, ties are broken in favour of nogoods used more often and of nogoods added
+   * later. The remaining nogoods are watched again by the next call of propagate() and their uses are halved, so that
+   * nogoods which are no longer used are eventually deleted.
+   */
+  inline size_t reduce(size_t maxNogoods) {
+    if ( nogoods.size() <= maxNogoods ) {
+      return 0;
+    }
+    std::vector<size_t> order(nogoods.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](size_t lhs, size_t rhs) {
+      if ( lbds[lhs] != lbds[rhs] ) {
+        return lbds[lhs] < lbds[rhs];
+      }
+      if ( uses[lhs] != uses[rhs] ) {
+        return uses[lhs] > uses[rhs];
+      }
+      return lhs > rhs;
+    });
+    order.resize(maxNogoods);
+    std::sort(order.begin(), order.end());
+
+    size_t deleted = nogoods.size() - maxNogoods;
+    literalCount = 0;
+    for ( size_t i = 0; i < order.size(); i++ ) {
+      if ( order[i] != i ) {
+        nogoods[i] = std::move(nogoods[order[i]]);
+        lbds[i] = lbds[order[i]];
+        uses[i] = uses[order[i]];
+      }
+      uses[i] /= 2;
+      literalCount += nogoods[i].size();
+    }
+    nogoods.resize(maxNogoods);
+    nogoods.shrink_to_fit();
+    lbds.resize(maxNogoods);
+    uses.resize(maxNogoods);
+    for ( auto& watching : watches ) {
+      watching.clear();
+    }
+    pending.resize(maxNogoods);
+    std::iota(pending.begin(), pending.end(), 0);
+    return deleted;
+  }
+
+  /**
+   * @brief Narrows the bounds by all nogoods and returns false if a nogood is violated.
+   *
+   * @param changed The inputs whose bounds changed since the last propagation, inputs narrowed by the nogoods are appended.
+   */
+  inline bool propagate(std::vector<Interval>& bounds, std::vector<size_t>& changed) {
+    if ( bounds.size() != watches.size() ) {
+      throw std::invalid_argument("CP: number of bounds does not match number of inputs");
+    }
+    // watch the literals of new nogoods which do not hold
+    for ( size_t nogood : pending ) {
+      auto& literals = nogoods[nogood];
+      std::stable_partition(literals.begin(), literals.end(), [&](const Literal& literal) { return !literal.isTrue(bounds); });
+      for ( size_t i = 0; i < std::min<size_t>(2, literals.size()); i++ ) {
+        watches[literals[i].input].push_back(nogood);
+      }
+      if ( literals[0].isTrue(bounds) ) {
+        uses[nogood]++;
+        pending.clear();
+        return false;
+      }
+      if ( literals.size() == 1 || literals[1].isTrue(bounds) ) {
+        if ( !enforce(nogood, literals[0].negation(), bounds, changed) ) {
+          pending.clear();
+          return false;
+        }
+      }
+    }
+    pending.clear();
+
+    for ( size_t next = 0; next < changed.size(); next++ ) {
+      size_t input = changed[next];
+      auto& watching = watches[input];
+      for ( size_t i = 0; i < watching.size(); ) {
+        size_t nogood = watching[i];
+        auto& literals = nogoods[nogood];
+        size_t watched = ( literals[0].input == input && literals[0].isTrue(bounds) ) ? 0 : 1;
+        if ( watched >= literals.size() || literals[watched].input != input || !literals[watched].isTrue(bounds) ) {
+          i++;
+          continue;
+        }
+        // watch another literal which does not hold
+        auto replacement = std::find_if(literals.begin() + 2, literals.end(), [&](const Literal& literal) { return !literal.isTrue(bounds); });
+        if ( replacement != literals.end() ) {
+          std::swap(literals[watched], *replacement);
+          if ( literals[watched].input != input ) {
+            watches[literals[watched].input].push_back(nogood);
+            watching[i] = watching.back();
+            watching.pop_back();
+            continue;
+          }
+          i++;
+          continue;
+        }
+        if ( literals.size() == 1 || literals[1 - watched].isTrue(bounds) ) {
+          uses[nogood]++;
+          return false;
+        }
+        if ( !enforce(nogood, literals[1 - watched].negation(), bounds, changed) ) {
+          return false;
+        }
+        i++;
+      }
+    }
+    return true;
+  }
+
+private:
+  std::vector< std::vector<Literal> > nogoods;
+  std::vector<size_t> lbds;
+  std::vector<size_t> uses;
+  size_t literalCount = 0;
+  std::vector< std::vector<size_t> > watches; ///< Nogoods watching a literal of each input
+  std::vector<size_t> pending; ///< Nogoods added since the last propagation
+
+  inline bool enforce(size_t nogood, const Literal& literal, std::vector<Interval>& bounds, std::vector<size_t>& changed) {
+    if ( literal.isTrue(bounds) ) {
+      return true;
+    }
+    uses[nogood]++;
+    changed.push_back(literal.input);
+    return literal.apply(bounds);
+  }
+};
+
+} // end namespace CP
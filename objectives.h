@@ -0,0 +1,149 @@
+ /**
+ ******************************************************************************
+ *
+ *  Lexicographic and Pareto comparison of objective values
+ *
+ ******************************************************************************
+ */
+
+#pragma once
+
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+
+#include "cp.h"
+
+namespace CP {
+
+/*******************************************
+ * Lexicographic comparison
+ ******************************************/
+
+/**
+ * @brief Returns the senses of all objectives of a model in lexicographic order.
+ */
+inline std::vector<Model::ObjectiveSense> getObjectiveSenses(const Model& model) {
+  std::vector<Model::ObjectiveSense> senses;
+  for ( auto& objective : model.getObjectives() ) {
+    senses.push_back(objective.sense);
+  }
+  return senses;
+}
+
+/**
+ * @brief Returns -1 if lhs is better than rhs, 1 if rhs is better than lhs, and 0 otherwise with respect to the sense.
+ */
+inline int compareObjective(double lhs, double rhs, Model::ObjectiveSense sense, double tolerance = 1e-9) {
+  if ( sense == Model::ObjectiveSense::FEASIBLE || std::abs(lhs - rhs) <= tolerance * std::max(1.0, std::abs(rhs)) ) {
+    return 0;
+  }
+  return ( sense == Model::ObjectiveSense::MINIMIZE ) == ( lhs < rhs ) ? -1 : 1;
+}
+
+/**
+ * @brief Returns true if the objective values lhs are lexicographically better than the objective values rhs.
+ */
+inline bool isLexicographicallyBetter(const std::vector<double>& lhs, const std::vector<double>& rhs, const std::vector<Model::ObjectiveSense>& senses) {
+  if ( lhs.size() != senses.size() || rhs.size() != senses.size() ) {
+    throw std::invalid_argument("CP: number of objective values does not match number of objectives");
+  }
+  for ( size_t i = 0; i < senses.size(); i++ ) {
+    if ( int comparison = compareObjective(lhs[i], rhs[i], senses[i]) ) {
+      return comparison < 0;
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief Returns false if no objective values within the given bounds can be lexicographically better than the incumbent.
+ *
+ * A search may prune all nodes for which the bounds of the objectives, e.g. obtained by Tape::bounds(), cannot improve the incumbent.
+ */
+inline bool mayImprove(const std::vector<Interval>& bounds, const std::vector<double>& incumbent, const std::vector<Model::ObjectiveSense>& senses) {
+  if ( bounds.size() != senses.size() || incumbent.size() != senses.size() ) {
+    throw std::invalid_argument("CP: number of objective values does not match number of objectives");
+  }
+  for ( size_t i = 0; i < senses.size(); i++ ) {
+    double best = senses[i] == Model::ObjectiveSense::MAXIMIZE ? bounds[i].upperBound : bounds[i].lowerBound;
+    // if the best value equals the incumbent, only later objectives may improve
+    if ( int comparison = compareObjective(best, incumbent[i], senses[i]) ) {
+      return comparison < 0;
+    }
+  }
+  return false;
+}
+
+/*******************************************
+ * ParetoFront
+ ******************************************/
+
+/**
+ * @brief Maintains the set of mutually non-dominated objective values found so far together with the respective solutions.
+ *
+ * @tparam Solution The type used to represent a solution, e.g. the values of the inputs of a tape.
+ */
+template<typename Solution>
+class ParetoFront {
+public:
+  struct Entry {
+    std::vector<double> objectives;
+    Solution solution;
+  };
+
+  inline ParetoFront(std::vector<Model::ObjectiveSense> senses) : senses(std::move(senses)) {};
+  inline ParetoFront(const Model& model) : senses(getObjectiveSenses(model)) {};
+
+  /**
+   * @brief Returns true if lhs dominates rhs, i.e. lhs is not worse for any objective and better for at least one objective.
+   */
+  inline bool dominates(const std::vector<double>& lhs, const std::vector<double>& rhs) const {
+    bool better = false;
+    for ( size_t i = 0; i < senses.size(); i++ ) {
+      int comparison = compareObjective(lhs[i], rhs[i], senses[i]);
+      if ( comparison > 0 ) {
+        return false;
+      }
+      better = better || comparison < 0;
+    }
+    return better;
+  }
+
+  /**
+   * @brief Adds the objective values and the solution to the front if they are not dominated by or equal to an entry and removes all entries dominated by them.
+   *
+   * @returns true if the front was changed.
+   */
+  inline bool add(std::vector<double> objectives, Solution solution) {
+    if ( objectives.size() != senses.size() ) {
+      throw std::invalid_argument("CP: number of objective values does not match number of objectives");
+    }
+    for ( auto& entry : entries ) {
+      if ( dominates(entry.objectives, objectives) || equals(entry.objectives, objectives) ) {
+        return false;
+      }
+    }
+    std::erase_if( entries, [&](const Entry& entry) { return dominates(objectives, entry.objectives); } );
+    entries.push_back({ std::move(objectives), std::move(solution) });
+    return true;
+  }
+
+  inline bool equals(const std::vector<double>& lhs, const std::vector<double>& rhs) const {
+    for ( size_t i = 0; i < senses.size(); i++ ) {
+      if ( compareObjective(lhs[i], rhs[i], senses[i]) ) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  inline const std::vector<Entry>& getEntries() const { return entries; };
+  inline size_t size() const { return entries.size(); };
+
+private:
+  std::vector<Model::ObjectiveSense> senses;
+  std::vector<Entry> entries;
+};
+
+} // end namespace CP
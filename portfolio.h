@@ -0,0 +1,191 @@
+ /**
+ ******************************************************************************
+ *
+ *  Parallel portfolio of searches with a deterministic mode
+ *
+ ******************************************************************************
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+
+#include "cp.h"
+#include "search.h"
+#include "heuristics.h"
+#include "objectives.h"
+#include "thread_pool.h"
+
+namespace CP {
+
+/*******************************************
+ * Portfolio
+ ******************************************/
+
+/**
+ * @brief Runs one search per thread of a pool with different heuristics and seeds, which share their best solutions.
+ *
+ * The search of worker k uses the heuristic FirstFail, DomWdeg, ActivityBased, or ImpactBased for k modulo 4, Luby
+ * restarts, and the seed plus k. The searches run in slices of a given number of nodes. After each slice, a worker
+ * shares its best solution if it improves on the shared solution and adopts the shared solution otherwise.
+ *
+ * In nondeterministic mode the workers share their solutions whenever they complete a slice, so that the results depend
+ * on the timing of the threads. In deterministic mode all workers complete a slice before the solutions are shared in
+ * the order of the workers, so that a run with the same model, seed, and number of threads yields identical results.
+ * The time limit is then only checked between slices, hence the result is reproducible unless the time limit is
+ * reached. The throughput loss is bounded by the time in which the fastest worker waits for the slowest worker in each
+ * slice.
+ */
+class Portfolio {
+public:
+  enum class Mode { NONDETERMINISTIC, DETERMINISTIC };
+
+  struct Statistics {
+    size_t nodes = 0; ///< Number of nodes of all searches
+    size_t slices = 0; ///< Number of slices completed by all workers
+    size_t exchanges = 0; ///< Number of solutions adopted from other workers
+  };
+
+  inline Portfolio(const Model& model, ThreadPool& pool, uint64_t seed = 0, size_t maxRounds = 100) : pool(pool), senses(getObjectiveSenses(model)) {
+    searches.reserve(pool.size());
+    for ( size_t worker = 0; worker < pool.size(); worker++ ) {
+      auto& search = searches.emplace_back(model, maxRounds);
+      switch ( worker % 4 ) {
+        case 1: search.setHeuristic(std::make_unique<DomWdeg>()); break;
+        case 2: search.setHeuristic(std::make_unique<ActivityBased>()); break;
+        case 3: search.setHeuristic(std::make_unique<ImpactBased>()); break;
+        default: break;
+      }
+      search.setRestarts(Search::Restarts::LUBY);
+      search.setSeed(seed + worker);
+    }
+  }
+
+  inline size_t size() const { return searches.size(); };
+  inline Search& getSearch(size_t worker) { return searches.at(worker); };
+  inline const std::vector<const Variable*>& getInputs() const { return searches.front().getInputs(); };
+  inline const Statistics& getStatistics() const { return statistics; };
+
+  /**
+   * @brief Sets the mode and the number of nodes explored by each worker between two exchanges of solutions.
+   */
+  inline void setMode(Mode value, size_t nodesPerSlice = 1000) {
+    if ( nodesPerSlice == 0 ) {
+      throw std::invalid_argument("CP: portfolio requires positive number of nodes per slice");
+    }
+    mode = value;
+    sliceNodes = nodesPerSlice;
+  }
+
+  /**
+   * @brief Returns true if a search was completed, i.e. the model is infeasible or the best solution is optimal.
+   */
+  inline bool isComplete() const { return complete; };
+
+  /**
+   * @brief Searches for a solution, or for an optimal solution if the model has an objective, and returns the best solution found.
+   *
+   * @param nodeLimit The number of nodes of all searches after which no further slice is started.
+   */
+  inline std::optional< std::vector<double> > solve(std::chrono::steady_clock::duration timeLimit = std::chrono::seconds(10), size_t nodeLimit = std::numeric_limits<size_t>::max()) {
+    CP_TRACE_SCOPE("Portfolio::solve");
+    auto now = std::chrono::steady_clock::now();
+    auto deadline = ( timeLimit < std::chrono::steady_clock::time_point::max() - now ) ? now + timeLimit : std::chrono::steady_clock::time_point::max();
+    if ( mode == Mode::DETERMINISTIC ) {
+      while ( !isDone() && statistics.nodes < nodeLimit && std::chrono::steady_clock::now() < deadline ) {
+        pool.run( searches.size(), [&](size_t worker) {
+          searches[worker].solve(std::chrono::steady_clock::duration::max(), sliceNodes);
+        } );
+        statistics.slices += searches.size();
+        for ( size_t worker = 0; worker < searches.size(); worker++ ) {
+          collect(worker);
+        }
+        for ( size_t worker = 0; worker < searches.size(); worker++ ) {
+          distribute(worker);
+        }
+        updateNodes();
+      }
+      return best;
+    }
+
+    std::mutex mutex;
+    std::atomic<bool> done = isDone();
+    std::atomic<size_t> nodes = statistics.nodes;
+    pool.run( searches.size(), [&](size_t worker) {
+      auto& search = searches[worker];
+      while ( !done.load() && nodes.load() < nodeLimit && std::chrono::steady_clock::now() < deadline ) {
+        size_t previous = search.getStatistics().nodes;
+        search.solve(deadline - std::chrono::steady_clock::now(), sliceNodes);
+        nodes += search.getStatistics().nodes - previous;
+        std::lock_guard lock(mutex);
+        statistics.slices++;
+        collect(worker);
+        distribute(worker);
+        if ( isDone() ) {
+          done = true;
+        }
+      }
+    } );
+    updateNodes();
+    return best;
+  }
+
+private:
+  ThreadPool& pool;
+  std::vector<Model::ObjectiveSense> senses;
+  std::vector<Search> searches;
+  Mode mode = Mode::NONDETERMINISTIC;
+  size_t sliceNodes = 1000;
+  std::optional< std::vector<double> > best;
+  std::vector<double> bestObjectives;
+  bool complete = false;
+  Statistics statistics;
+
+  inline bool isDone() const {
+    return complete || ( best && senses.front() == Model::ObjectiveSense::FEASIBLE );
+  }
+
+  /**
+   * @brief Returns true if the objectives are lexicographically better than the objectives of the shared solution.
+   */
+  inline bool isBetter(const std::vector<double>& objectives) const {
+    return !best || isLexicographicallyBetter(objectives, bestObjectives, senses);
+  }
+
+  /**
+   * @brief Records whether a worker completed its search and shares its best solution if it improves on the shared solution.
+   *
+   * In nondeterministic mode only called by the thread of the worker, so that the search is not read by other threads.
+   */
+  inline void collect(size_t worker) {
+    auto& search = searches[worker];
+    complete = complete || search.isComplete();
+    if ( search.getBest() && isBetter(search.getBestObjectives()) ) {
+      best = search.getBest();
+      bestObjectives = search.getBestObjectives();
+    }
+  }
+
+  /**
+   * @brief Lets a worker adopt the shared solution if it improves on the best solution of the worker.
+   */
+  inline void distribute(size_t worker) {
+    if ( best && searches[worker].setIncumbent(*best) ) {
+      statistics.exchanges++;
+    }
+  }
+
+  inline void updateNodes() {
+    statistics.nodes = 0;
+    for ( auto& search : searches ) {
+      statistics.nodes += search.getStatistics().nodes;
+    }
+  }
+};
+
+} // end namespace CP
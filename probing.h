@@ -0,0 +1,251 @@
+ /**
+ ******************************************************************************
+ *
+ *  Probing on boolean variables
+ *
+ ******************************************************************************
+ */
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <numeric>
+#include <span>
+#include <stdexcept>
+
+#include "cp.h"
+#include "tape.h"
+#include "conflicts.h"
+#include "thread_pool.h"
+
+namespace CP {
+
+/*******************************************
+ * Prober
+ ******************************************/
+
+/**
+ * @brief Determines fixed literals, implications, and implied bounds by tentatively fixing boolean inputs and propagating.
+ *
+ * Each boolean input b which is not fixed is probed by propagating the hard constraints with b = 0 and with b = 1. If one
+ * value yields empty bounds, b is fixed to the other value. Otherwise, the bounds of other inputs narrowed for b = v are
+ * recorded as implied bounds of the literal b = v, e.g. y = 1 implies x >= 4, and bounds narrowed for both values are
+ * tightened. The implied bounds are stored in a table with one contiguous range of entries per literal.
+ */
+class Prober {
+public:
+  /**
+   * @brief Represents the bounds of an input implied by a literal.
+   */
+  struct ImpliedBound {
+    size_t input;
+    Interval bounds;
+  };
+
+  inline Prober(const Model& model, size_t maxRounds = 100) : analyzer(model, maxRounds) {
+    auto& inputs = analyzer.getChecker().getInputs();
+    constraints.resize(analyzer.size());
+    std::iota(constraints.begin(), constraints.end(), 0);
+    for ( auto variable : inputs ) {
+      bounds.push_back({ variable->lowerBound, variable->upperBound });
+    }
+    start.assign(2 * inputs.size() + 1, 0);
+  }
+
+  /**
+   * @brief Probes all boolean inputs which are not fixed and returns false if the model is proven to be infeasible.
+   *
+   * The inputs are distributed over the threads of the pool, each propagating with its own copy of the tape. Inputs not
+   * probed when the time limit is reached are skipped, see isComplete(). Unlike the time limit, the limit on the number
+   * of probed inputs does not depend on the speed of the threads, so that the result is reproducible for any number of
+   * threads if only the probe limit is reached.
+   *
+   * @param probeLimit The maximal number of inputs probed.
+   */
+  inline bool probe(ThreadPool& pool, std::chrono::steady_clock::duration timeLimit = std::chrono::seconds(1), size_t probeLimit = std::numeric_limits<size_t>::max()) {
+    CP_TRACE_SCOPE("Prober::probe");
+    auto now = std::chrono::steady_clock::now();
+    auto deadline = ( timeLimit < std::chrono::steady_clock::time_point::max() - now ) ? now + timeLimit : std::chrono::steady_clock::time_point::max();
+    auto& inputs = analyzer.getChecker().getInputs();
+    Tape tape = analyzer.getChecker().getTape();
+    if ( !analyzer.propagate(constraints, bounds, tape) ) {
+      return infeasible();
+    }
+
+    std::vector<size_t> candidates;
+    for ( size_t input = 0; input < inputs.size(); input++ ) {
+      if ( inputs[input]->type == Variable::Type::BOOLEAN && bounds[input].lowerBound < bounds[input].upperBound ) {
+        candidates.push_back(input);
+      }
+    }
+    bool skipped = candidates.size() > probeLimit;
+    candidates.resize(std::min(candidates.size(), probeLimit));
+
+    // propagate both values of each candidate
+    struct Result {
+      bool probed = false;
+      std::array<bool,2> feasible = {};
+      std::array<std::vector<Interval>,2> bounds;
+    };
+    std::vector<Result> results(candidates.size());
+    std::vector<Tape> tapes(pool.size(), tape);
+    pool.run( pool.size(), [&](size_t k) {
+      for ( size_t i = k; i < candidates.size(); i += pool.size() ) {
+        if ( std::chrono::steady_clock::now() > deadline ) {
+          return;
+        }
+        for ( size_t value = 0; value < 2; value++ ) {
+          results[i].bounds[value] = bounds;
+          results[i].bounds[value][candidates[i]] = { (double)value, (double)value };
+          results[i].feasible[value] = analyzer.propagate(constraints, results[i].bounds[value], tapes[k]);
+        }
+        results[i].probed = true;
+      }
+    } );
+
+    // collect fixed literals, tightened bounds, and implied bounds
+    complete = !skipped;
+    std::vector< std::vector<ImpliedBound> > literals(2 * inputs.size());
+    for ( size_t i = 0; i < candidates.size(); i++ ) {
+      auto& result = results[i];
+      if ( !result.probed ) {
+        complete = false;
+        continue;
+      }
+      if ( !result.feasible[0] && !result.feasible[1] ) {
+        return infeasible();
+      }
+      if ( !result.feasible[0] || !result.feasible[1] ) {
+        double value = result.feasible[1];
+        bounds[candidates[i]] = { value, value };
+        continue;
+      }
+      for ( size_t input = 0; input < inputs.size(); input++ ) {
+        bounds[input].lowerBound = std::max(bounds[input].lowerBound, std::min(result.bounds[0][input].lowerBound, result.bounds[1][input].lowerBound));
+        bounds[input].upperBound = std::min(bounds[input].upperBound, std::max(result.bounds[0][input].upperBound, result.bounds[1][input].upperBound));
+      }
+      for ( size_t value = 0; value < 2; value++ ) {
+        for ( size_t input = 0; input < inputs.size(); input++ ) {
+          if ( input != candidates[i] && isTighter(result.bounds[value][input], bounds[input]) ) {
+            literals[2 * candidates[i] + value].push_back({ input, result.bounds[value][input] });
+          }
+        }
+      }
+    }
+    if ( !analyzer.propagate(constraints, bounds, tape) ) {
+      return infeasible();
+    }
+
+    // store implied bounds of literals whose input is not fixed
+    implications.clear();
+    for ( size_t literal = 0; literal < literals.size(); literal++ ) {
+      start[literal] = implications.size();
+      if ( bounds[literal / 2].lowerBound < bounds[literal / 2].upperBound ) {
+        for ( auto& implication : literals[literal] ) {
+          if ( isTighter(implication.bounds, bounds[implication.input]) ) {
+            implications.push_back(implication);
+          }
+        }
+      }
+    }
+    start.back() = implications.size();
+    return true;
+  }
+
+  inline const std::vector<const Variable*>& getInputs() const { return analyzer.getChecker().getInputs(); };
+
+  /**
+   * @brief Returns true if all boolean inputs were probed within the limits of the last probing.
+   */
+  inline bool isComplete() const { return complete; };
+
+  /**
+   * @brief Returns the bounds of the inputs after probing in the order of FeasibilityChecker::getInputs().
+   */
+  inline const std::vector<Interval>& getBounds() const { return bounds; };
+
+  /**
+   * @brief Returns the bounds of a variable after probing, which are fixed for fixed literals.
+   */
+  inline Interval getBounds(const Variable& variable) const { return bounds[getInput(variable)]; };
+
+  /**
+   * @brief Returns the bounds implied by the literal that a boolean variable has the given value.
+   */
+  inline std::span<const ImpliedBound> getImplications(const Variable& variable, bool value) const {
+    size_t literal = 2 * getInput(variable) + value;
+    return std::span<const ImpliedBound>(implications.data() + start[literal], start[literal + 1] - start[literal]);
+  }
+
+  /**
+   * @brief Returns the bounds of a variable given that a boolean variable has the given value, e.g. to tighten a big-M coefficient.
+   */
+  inline Interval getImpliedBounds(const Variable& variable, const Variable& literal, bool value) const {
+    size_t input = getInput(variable);
+    for ( auto& implication : getImplications(literal, value) ) {
+      if ( implication.input == input ) {
+        return implication.bounds;
+      }
+    }
+    return bounds[input];
+  }
+
+  /**
+   * @brief Intersects the bounds of the inputs with the implied bounds of all fixed boolean inputs and returns false if the bounds become empty.
+   */
+  inline bool propagate(std::vector<Interval>& inputBounds) const {
+    if ( inputBounds.size() != bounds.size() ) {
+      throw std::invalid_argument("CP: number of bounds does not match number of inputs");
+    }
+    for ( size_t input = 0; input < inputBounds.size(); input++ ) {
+      auto [lowerBound, upperBound] = inputBounds[input];
+      if ( lowerBound != upperBound || ( lowerBound != 0.0 && lowerBound != 1.0 ) ) {
+        continue;
+      }
+      size_t literal = 2 * input + (size_t)lowerBound;
+      for ( size_t i = start[literal]; i < start[literal + 1]; i++ ) {
+        auto& [implied, impliedBounds] = implications[i];
+        inputBounds[implied].lowerBound = std::max(inputBounds[implied].lowerBound, impliedBounds.lowerBound);
+        inputBounds[implied].upperBound = std::min(inputBounds[implied].upperBound, impliedBounds.upperBound);
+        if ( inputBounds[implied].lowerBound > inputBounds[implied].upperBound ) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+private:
+  ConflictAnalyzer analyzer;
+  std::vector<size_t> constraints;
+  std::vector<Interval> bounds;
+  std::vector<size_t> start; ///< Index of the first implied bound of each literal 2 * input + value
+  std::vector<ImpliedBound> implications;
+  bool complete = true;
+
+  inline size_t getInput(const Variable& variable) const {
+    auto& inputs = analyzer.getChecker().getInputs();
+    auto it = std::find(inputs.begin(), inputs.end(), &variable);
+    if ( it == inputs.end() ) {
+      throw std::invalid_argument("CP: variable '" + variable.name + "' is not an input of the model");
+    }
+    return (size_t)(it - inputs.begin());
+  }
+
+  inline static bool isTighter(const Interval& implied, const Interval& bounds) {
+    return implied.lowerBound > bounds.lowerBound + 1e-9 * std::max(1.0, std::abs(bounds.lowerBound))
+      || implied.upperBound < bounds.upperBound - 1e-9 * std::max(1.0, std::abs(bounds.upperBound));
+  }
+
+  inline bool infeasible() {
+    implications.clear();
+    std::fill(start.begin(), start.end(), 0);
+    return false;
+  }
+};
+
+} // end namespace CP
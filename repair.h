@@ -0,0 +1,220 @@
+ /**
+ ******************************************************************************
+ *
+ *  Repair of infeasible models by relaxation of bounds and constraints
+ *
+ ******************************************************************************
+ */
+
+#pragma once
+
+#include <chrono>
+#include <limits>
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+
+#include "cp.h"
+#include "conflicts.h"
+
+namespace CP {
+
+/*******************************************
+ * FeasibilityRepair
+ ******************************************/
+
+/**
+ * @brief Determines relaxations of bounds of variables and of hard constraints which restore the feasibility of a model.
+ *
+ * Each finite bound of an input variable and each hard constraint, numbered like in FeasibilityChecker, is an item with a
+ * weight. A repair relaxes a set of items such that interval propagation no longer detects infeasibility, where relaxed
+ * bounds are removed and relaxed constraints are ignored, e.g. to be added as soft constraints instead.
+ *
+ * Starting with all items relaxed, the items are enforced again one by one by decreasing weight unless enforcing an item
+ * makes the model infeasible. The resulting relaxations form a minimal correction set, i.e. enforcing any relaxed item
+ * makes the model infeasible. The plan of the previous repair is kept as fallback, so that a repeated repair after
+ * changes of the weights returns the previous plan if it is cheaper for the current weights than the new plan, e.g.
+ * because the time limit was reached. If the time limit is reached, all items not yet enforced remain relaxed, so that
+ * a valid but possibly non-minimal plan is returned.
+ */
+class FeasibilityRepair {
+public:
+  /**
+   * @brief Represents the relaxation of a bound or a constraint.
+   */
+  struct Relaxation {
+    enum class Type { CONSTRAINT, LOWER_BOUND, UPPER_BOUND };
+    Type type;
+    size_t index; ///< Index of the constraint or of the input
+    double weight;
+  };
+
+  inline FeasibilityRepair(const Model& model, size_t maxRounds = 100) : analyzer(model, maxRounds) {
+    auto& inputs = analyzer.getChecker().getInputs();
+    for ( size_t constraint = 0; constraint < analyzer.size(); constraint++ ) {
+      items.push_back({ Relaxation::Type::CONSTRAINT, constraint, 1.0 });
+    }
+    for ( size_t input = 0; input < inputs.size(); input++ ) {
+      if ( inputs[input]->lowerBound != std::numeric_limits<double>::lowest() ) {
+        items.push_back({ Relaxation::Type::LOWER_BOUND, input, 1.0 });
+      }
+      if ( inputs[input]->upperBound != std::numeric_limits<double>::max() ) {
+        items.push_back({ Relaxation::Type::UPPER_BOUND, input, 1.0 });
+      }
+    }
+    enforced.assign(items.size(), false);
+  }
+
+  /**
+   * @brief Sets the weight of relaxing a constraint.
+   */
+  inline void setWeight(size_t constraint, double weight) {
+    setWeight(Relaxation::Type::CONSTRAINT, constraint, weight);
+  }
+
+  /**
+   * @brief Sets the weights of relaxing the bounds of an input variable, weights of infinite bounds are ignored.
+   */
+  inline void setWeight(const Variable& variable, double lowerBoundWeight, double upperBoundWeight) {
+    auto& inputs = analyzer.getChecker().getInputs();
+    auto it = std::find(inputs.begin(), inputs.end(), &variable);
+    if ( it == inputs.end() ) {
+      throw std::invalid_argument("CP: variable '" + variable.name + "' is not an input of the model");
+    }
+    size_t input = (size_t)(it - inputs.begin());
+    if ( variable.lowerBound != std::numeric_limits<double>::lowest() ) {
+      setWeight(Relaxation::Type::LOWER_BOUND, input, lowerBoundWeight);
+    }
+    if ( variable.upperBound != std::numeric_limits<double>::max() ) {
+      setWeight(Relaxation::Type::UPPER_BOUND, input, upperBoundWeight);
+    }
+  }
+
+  /**
+   * @brief Returns relaxations restoring feasibility, which are empty if the model is not detected to be infeasible.
+   *
+   * @param timeLimit The time after which all items not yet enforced remain relaxed.
+   */
+  inline std::vector<Relaxation> repair(std::chrono::steady_clock::duration timeLimit = std::chrono::seconds(1)) {
+    auto deadline = std::chrono::steady_clock::now() + timeLimit;
+    std::vector<size_t> order(items.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t lhs, size_t rhs) { return items[lhs].weight > items[rhs].weight; });
+
+    // the previous plan is the fallback if the new plan is not cheaper
+    auto previous = std::move(enforced);
+    bool previousMinimal = minimal;
+    enforced.assign(items.size(), false);
+    minimal = true;
+    for ( size_t item : order ) {
+      if ( std::chrono::steady_clock::now() > deadline ) {
+        minimal = false;
+        break;
+      }
+      enforced[item] = true;
+      if ( isInfeasible() ) {
+        enforced[item] = false;
+      }
+    }
+    if ( planned && relaxedWeight(previous) < relaxedWeight(enforced) ) {
+      enforced = std::move(previous);
+      minimal = previousMinimal;
+    }
+    planned = true;
+
+    std::vector<Relaxation> result;
+    for ( size_t item = 0; item < items.size(); item++ ) {
+      if ( !enforced[item] ) {
+        result.push_back(items[item]);
+      }
+    }
+    return result;
+  }
+
+  /**
+   * @brief Returns true if the last repair was completed within the time limit, i.e. each relaxation is necessary.
+   */
+  inline bool isMinimal() const { return minimal; };
+
+  inline static double getWeight(const std::vector<Relaxation>& relaxations) {
+    double result = 0.0;
+    for ( auto& relaxation : relaxations ) {
+      result += relaxation.weight;
+    }
+    return result;
+  }
+
+  inline std::string stringify(const Relaxation& relaxation) const {
+    auto& inputs = analyzer.getChecker().getInputs();
+    switch ( relaxation.type ) {
+      case Relaxation::Type::CONSTRAINT:
+        return std::format("relax constraint {} [ weight {:.2f} ]", analyzer.stringify(relaxation.index), relaxation.weight);
+      case Relaxation::Type::LOWER_BOUND:
+        return std::format("relax {} >= {:.2f} [ weight {:.2f} ]", inputs[relaxation.index]->name, inputs[relaxation.index]->lowerBound, relaxation.weight);
+      default:
+        return std::format("relax {} <= {:.2f} [ weight {:.2f} ]", inputs[relaxation.index]->name, inputs[relaxation.index]->upperBound, relaxation.weight);
+    }
+  }
+
+private:
+  ConflictAnalyzer analyzer;
+  std::vector<Relaxation> items;
+  std::vector<bool> enforced; ///< Whether each item is enforced by the last repair
+  bool minimal = true;
+  bool planned = false; ///< Whether a repair was determined before
+
+  /**
+   * @brief Returns the total weight of the items not enforced.
+   */
+  inline double relaxedWeight(const std::vector<bool>& plan) const {
+    double result = 0.0;
+    for ( size_t item = 0; item < items.size(); item++ ) {
+      if ( !plan[item] ) {
+        result += items[item].weight;
+      }
+    }
+    return result;
+  }
+
+  inline void setWeight(Relaxation::Type type, size_t index, double weight) {
+    if ( weight < 0.0 ) {
+      throw std::invalid_argument("CP: relaxation requires non-negative weight");
+    }
+    for ( auto& item : items ) {
+      if ( item.type == type && item.index == index ) {
+        item.weight = weight;
+        return;
+      }
+    }
+    throw std::invalid_argument("CP: unknown relaxation");
+  }
+
+  /**
+   * @brief Returns true if propagation detects that the enforced items are infeasible.
+   */
+  inline bool isInfeasible() {
+    constexpr double lowest = std::numeric_limits<double>::lowest();
+    constexpr double max = std::numeric_limits<double>::max();
+    std::vector<size_t> constraints;
+    std::vector<Interval> bounds(analyzer.getChecker().getInputs().size(), { lowest, max });
+    auto& inputs = analyzer.getChecker().getInputs();
+    for ( size_t item = 0; item < items.size(); item++ ) {
+      if ( !enforced[item] ) {
+        continue;
+      }
+      auto& relaxation = items[item];
+      if ( relaxation.type == Relaxation::Type::CONSTRAINT ) {
+        constraints.push_back(relaxation.index);
+      }
+      else if ( relaxation.type == Relaxation::Type::LOWER_BOUND ) {
+        bounds[relaxation.index].lowerBound = inputs[relaxation.index]->lowerBound;
+      }
+      else {
+        bounds[relaxation.index].upperBound = inputs[relaxation.index]->upperBound;
+      }
+    }
+    return analyzer.isInfeasible(constraints, std::move(bounds));
+  }
+};
+
+} // end namespace CP
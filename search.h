@@ -0,0 +1,778 @@
+ /**
+ ******************************************************************************
+ *
+ *  Tree search with restarts and nogood recording
+ *
+ ******************************************************************************
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <optional>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+
+#include "cp.h"
+#include "tape.h"
+#include "conflicts.h"
+#include "nogoods.h"
+#include "heuristics.h"
+#include "incumbent_channel.h"
+#include "lazy_constraints.h"
+#include "objectives.h"
+
+namespace CP {
+
+/*******************************************
+ * Restarts
+ ******************************************/
+
+/**
+ * @brief Returns the i-th element of the Luby sequence 1, 1, 2, 1, 1, 2, 4, 1, 1, 2, ... for i >= 1.
+ */
+inline size_t luby(size_t i) {
+  while ( true ) {
+    size_t k = 1;
+    while ( ( (size_t)1 << k ) - 1 < i ) {
+      k++;
+    }
+    if ( i == ( (size_t)1 << k ) - 1 ) {
+      return (size_t)1 << (k - 1);
+    }
+    i -= ( (size_t)1 << (k - 1) ) - 1;
+  }
+}
+
+/*******************************************
+ * Search
+ ******************************************/
+
+/**
+ * @brief Depth-first search over the integer and boolean inputs of a model with propagation, restarts, and nogoods.
+ *
+ * At each node the bounds of the inputs are narrowed by interval propagation of the hard constraints, the permutation
+ * property of the sequences, and the nogoods. The search branches on a decision and its negation, e.g. `x <= lb` and
+ * `x >= lb + 1`, where the input and the decision are chosen by a Heuristic, by default FirstFail. If all inputs are
+ * fixed, the values are checked against all constraints. If the model has objectives, each solution found is used to
+ * bound the objectives, which are compared lexicographically, and the search continues until the search space is
+ * exhausted or the time limit is reached.
+ *
+ * When the number of failures since the last restart exceeds the limit given by the restart strategy, the search is
+ * restarted from the root. Before the restart, for each refuted decision on the current branch the decision together
+ * with all preceding positive decisions is recorded as a nogood (nld-nogoods), so that no part of the search space is
+ * explored twice.
+ *
+ * The memory of the search is dominated by the bounds stored for each decision on the current branch and by the
+ * nogoods, both of which can be limited by setMemoryLimits(). If the number of stored bounds reaches its limit, only the
+ * bounds before every second stored decision are kept and the bounds before the other decisions are recomputed when
+ * backtracking by applying and propagating the decisions after the nearest stored bounds. If the number of nogoods
+ * exceeds its limit, the nogoods are reduced to half of the limit, see NogoodDatabase::reduce(). Deleted nogoods may
+ * cause parts of the search space to be explored again after a restart.
+ *
+ * If lazy constraints are set, an assignment satisfying all constraints is only accepted as solution if the generators
+ * yield no new constraint. Otherwise the generated constraints are compiled onto the tape and propagated like the
+ * constraints of the model for the remainder of the search.
+ */
+class Search {
+public:
+  enum class Restarts { NONE, LUBY, GEOMETRIC };
+
+  struct Statistics {
+    size_t nodes = 0;
+    size_t failures = 0;
+    size_t restarts = 0;
+    size_t solutions = 0;
+    size_t nogoods = 0;
+    size_t deletedNogoods = 0;
+    size_t recomputations = 0; ///< Number of times the bounds before a decision were recomputed
+    size_t peakBytes = 0; ///< Peak number of bytes of stored bounds and nogoods
+    size_t lazyConstraints = 0; ///< Number of generated constraints added to the propagation
+    size_t failedPublications = 0; ///< Number of incumbents not published because all slots of the channel were read
+  };
+
+  inline Search(const Model& model, size_t maxRounds = 100)
+    : analyzer(model, maxRounds)
+    , maxRounds(maxRounds)
+    , tape(analyzer.getChecker().getTape())
+    , sense(model.getObjectiveSense())
+    , senses(getObjectiveSenses(model))
+    , bestObjectives(senses.size(), 0.0)
+  {
+    constraints.resize(analyzer.size());
+    std::iota(constraints.begin(), constraints.end(), 0);
+    // variables of sequences are inputs even if they are not used by any constraint
+    for ( auto& sequence : model.getSequences() ) {
+      for ( const Variable& variable : sequence.variables ) {
+        if ( !tape.getInputIndex(variable) ) {
+          tape.addOutput(Expression(variable));
+        }
+      }
+    }
+    for ( auto& sequence : model.getSequences() ) {
+      sequences.emplace_back();
+      for ( const Variable& variable : sequence.variables ) {
+        sequences.back().push_back( tape.getInputIndex(variable).value() );
+      }
+    }
+    for ( auto variable : tape.getInputs() ) {
+      if ( variable->type == Variable::Type::REAL ) {
+        throw std::invalid_argument("CP: search requires integer or boolean variable '" + variable->name + "'");
+      }
+      root.push_back({ variable->lowerBound, variable->upperBound });
+    }
+    nogoods = NogoodDatabase(root.size());
+
+    // inputs used by each constraint
+    auto& nodes = tape.getNodes();
+    auto& arguments = tape.getArguments();
+    std::vector<size_t> marks(nodes.size(), constraints.size());
+    std::vector<size_t> stack;
+    scopes.resize(constraints.size());
+    for ( size_t constraint : constraints ) {
+      stack.push_back(tape.getOutputs()[analyzer.getChecker().getOutput(constraint)]);
+      marks[stack.back()] = constraint;
+      while ( !stack.empty() ) {
+        auto& node = nodes[stack.back()];
+        stack.pop_back();
+        if ( node.opcode == Tape::Opcode::input ) {
+          scopes[constraint].push_back((size_t)node.constant);
+        }
+        for ( size_t i = node.first; i < node.first + node.count; i++ ) {
+          if ( marks[arguments[i]] != constraint ) {
+            marks[arguments[i]] = constraint;
+            stack.push_back(arguments[i]);
+          }
+        }
+      }
+      std::sort(scopes[constraint].begin(), scopes[constraint].end());
+    }
+    setHeuristic(std::make_unique<FirstFail>());
+  }
+
+  /**
+   * @brief Returns the inputs in the order of the values of a solution.
+   */
+  inline const std::vector<const Variable*>& getInputs() const { return tape.getInputs(); };
+
+  /**
+   * @brief Sets the restart strategy, where the i-th restart happens after scale * luby(i) or scale * factor^i failures.
+   */
+  inline void setRestarts(Restarts strategy, size_t scale = 100, double factor = 1.5) {
+    if ( scale == 0 || factor < 1.0 ) {
+      throw std::invalid_argument("CP: restarts require positive scale and factor of at least 1");
+    }
+    restarts = strategy;
+    restartScale = scale;
+    restartFactor = factor;
+  }
+
+  /**
+   * @brief Limits the number of decisions on the current branch storing the bounds before the decision and the number of nogoods.
+   */
+  inline void setMemoryLimits(size_t maxSnapshots, size_t maxNogoods = std::numeric_limits<size_t>::max()) {
+    if ( maxSnapshots == 0 ) {
+      throw std::invalid_argument("CP: search requires positive limit of stored bounds");
+    }
+    snapshotLimit = maxSnapshots;
+    nogoodLimit = maxNogoods;
+  }
+
+  /**
+   * @brief Sets the seed of the random number generator used by the heuristic for breaking ties.
+   */
+  inline void setSeed(uint64_t value) {
+    seed = value;
+    heuristic->seed(seed);
+  }
+
+  /**
+   * @brief Replaces the branching heuristic, which is initialized with the structure of the model.
+   */
+  inline void setHeuristic(std::unique_ptr<Heuristic> strategy) {
+    if ( !strategy ) {
+      throw std::invalid_argument("CP: search requires heuristic");
+    }
+    heuristic = std::move(strategy);
+    heuristic->initialize(root.size(), scopes, sequences);
+    heuristic->seed(seed);
+  }
+
+  inline Heuristic& getHeuristic() const { return *heuristic; };
+
+  /**
+   * @brief Sets a channel to which each improving solution is published, and the best solution once it is proven optimal.
+   *
+   * The bound of an incumbent is infinite unless the search is complete. The channel must outlive the search. If
+   * the slots of the channel are read by too many consumers, publishing an improving solution is retried a few times
+   * before the incumbent is dropped and counted as failed publication, whereas the optimal solution is retried until it
+   * is published.
+   */
+  inline void setChannel(IncumbentChannel* incumbents) {
+    if ( incumbents && incumbents->size() != root.size() ) {
+      throw std::invalid_argument("CP: size of incumbent channel does not match number of inputs");
+    }
+    channel = incumbents;
+    publication.assign(root.size(), 0.0);
+  }
+
+  /**
+   * @brief Sets the lazy constraints queried for each assignment satisfying all constraints, which must outlive the search.
+   */
+  inline void setLazyConstraints(LazyConstraints* constraints) {
+    lazy = constraints;
+    lazyCompiled = 0;
+  }
+
+  /**
+   * @brief Returns the inputs used by a constraint numbered like in FeasibilityChecker.
+   */
+  inline const std::vector<size_t>& getScope(size_t constraint) const { return scopes.at(constraint); };
+
+  inline const Statistics& getStatistics() const { return statistics; };
+  inline const NogoodDatabase& getNogoods() const { return nogoods; };
+
+  /**
+   * @brief Returns the best solution found or adopted, or std::nullopt if there is none.
+   */
+  inline const std::optional< std::vector<double> >& getBest() const { return best; };
+  inline double getBestObjective() const { return bestObjectives.front(); };
+
+  /**
+   * @brief Returns the values of all objectives of the best solution in lexicographic order.
+   */
+  inline const std::vector<double>& getBestObjectives() const { return bestObjectives; };
+
+  /**
+   * @brief Adopts a solution found elsewhere, e.g. by another search, and returns true if it is feasible and improves the best solution.
+   *
+   * Subsequent searches only look for solutions improving the adopted solution.
+   */
+  inline bool setIncumbent(const std::vector<double>& values) {
+    if ( values.size() != root.size() ) {
+      throw std::invalid_argument("CP: number of values does not match number of inputs");
+    }
+    std::vector<Interval> bounds;
+    bounds.reserve(values.size());
+    for ( size_t input = 0; input < values.size(); input++ ) {
+      auto variable = tape.getInputs()[input];
+      if ( values[input] < variable->lowerBound || values[input] > variable->upperBound || values[input] != std::round(values[input]) ) {
+        return false;
+      }
+      bounds.push_back({ values[input], values[input] });
+    }
+    return propagateSequences(bounds) && isSolution(bounds);
+  }
+
+  /**
+   * @brief Returns true if the last search was completed, i.e. the model is infeasible or the best solution is optimal.
+   */
+  inline bool isComplete() const { return complete; };
+
+  /**
+   * @brief Searches for a solution, or for an optimal solution if the model has an objective.
+   *
+   * If the time limit or the node limit is reached, the nogoods of the current branch are recorded, so that another call
+   * continues the search from the root with the best solution found so far without exploring any part of the search
+   * space again. As the node limit does not depend on the time, a search interrupted by node limits is reproducible.
+   *
+   * @param nodeLimit The maximal number of decisions made by this call.
+   * @returns The values of the inputs of the best solution found, or std::nullopt if no solution was found.
+   */
+  inline std::optional< std::vector<double> > solve(std::chrono::steady_clock::duration timeLimit = std::chrono::seconds(10), size_t nodeLimit = std::numeric_limits<size_t>::max()) {
+    CP_TRACE_SCOPE("Search::solve");
+    auto now = std::chrono::steady_clock::now();
+    deadline = ( timeLimit < std::chrono::steady_clock::time_point::max() - now ) ? now + timeLimit : std::chrono::steady_clock::time_point::max();
+    size_t lastNode = statistics.nodes + std::min(nodeLimit, std::numeric_limits<size_t>::max() - statistics.nodes);
+    if ( complete || ( best && sense == Model::ObjectiveSense::FEASIBLE ) ) {
+      return best;
+    }
+    size_t failuresSinceRestart = 0;
+    std::vector<size_t> changed(root.size());
+    std::iota(changed.begin(), changed.end(), 0);
+    if ( !propagate(root, changed) ) {
+      completed();
+      return best;
+    }
+    auto bounds = root;
+    clearPath();
+
+    while ( std::chrono::steady_clock::now() < deadline ) {
+      bool failed = false;
+      auto input = heuristic->select(bounds);
+      // a leaf reached by the last decision is checked, so that a search interrupted at this depth progresses
+      if ( input && statistics.nodes >= lastNode ) {
+        break;
+      }
+      if ( input ) {
+        // positive decision
+        auto decision = decide(*input, bounds);
+        pushFrame(bounds, decision);
+        statistics.nodes++;
+        heuristic->decided(decision, bounds);
+        decision.apply(bounds);
+        changed.assign(1, *input);
+        failed = !propagate(bounds, changed);
+        heuristic->propagated(!failed);
+        if ( failed ) {
+          heuristic->failed(conflict);
+        }
+      }
+      else {
+        failed = true;
+        if ( isSolution(bounds) ) {
+          statistics.solutions++;
+          if ( sense == Model::ObjectiveSense::FEASIBLE ) {
+            return best;
+          }
+        }
+      }
+      if ( !failed ) {
+        continue;
+      }
+
+      statistics.failures++;
+      failuresSinceRestart++;
+      if ( restarts != Restarts::NONE && failuresSinceRestart >= getRestartLimit() ) {
+        recordNogoods();
+        clearPath();
+        statistics.restarts++;
+        failuresSinceRestart = 0;
+        heuristic->restarted();
+        changed.clear();
+        if ( !propagate(root, changed) ) {
+          completed();
+          return best;
+        }
+        bounds = root;
+        continue;
+      }
+      if ( !backtrack(bounds) ) {
+        completed();
+        return best;
+      }
+    }
+    recordNogoods();
+    clearPath();
+    return best;
+  }
+
+private:
+  struct Frame {
+    std::vector<Interval> bounds; ///< Bounds before the decision, or empty if they must be recomputed
+    Literal decision;
+    bool refuted; ///< True if the negation of the decision is explored
+  };
+
+  ConflictAnalyzer analyzer;
+  size_t maxRounds;
+  std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max(); ///< Deadline of the current search
+  Tape tape; ///< Copy of the tape of the checker with the variables of all sequences as inputs
+  Model::ObjectiveSense sense; ///< Sense of the first objective
+  std::vector<Model::ObjectiveSense> senses; ///< Senses of all objectives, which are the first outputs of the tape
+  std::vector<size_t> constraints;
+  std::vector< std::vector<size_t> > sequences; ///< Inputs of the variables of each sequence
+  std::vector< std::vector<size_t> > scopes; ///< Inputs used by each constraint
+  std::vector<Interval> root;
+  NogoodDatabase nogoods;
+  std::vector<Frame> path;
+  size_t snapshots = 0; ///< Number of frames on the path storing their bounds
+  size_t snapshotInterval = 1; ///< Distance between frames storing their bounds
+  size_t snapshotLimit = std::numeric_limits<size_t>::max();
+  size_t nogoodLimit = std::numeric_limits<size_t>::max();
+  std::optional< std::vector<double> > best;
+  std::vector<double> bestObjectives; ///< Values of the objectives of the best solution
+  std::vector<Interval> objectiveBounds; ///< Bounds of the objectives computed when pruning
+  Restarts restarts = Restarts::NONE;
+  size_t restartScale = 100;
+  double restartFactor = 1.5;
+  std::unique_ptr<Heuristic> heuristic;
+  uint64_t seed = std::mt19937_64::default_seed;
+  IncumbentChannel* channel = nullptr;
+  std::vector<double> publication; ///< Buffer swapped with a slot of the channel when publishing
+  LazyConstraints* lazy = nullptr;
+  std::vector<size_t> lazyOutputs; ///< Outputs of the tape with the violations of the generated constraints
+  size_t lazyCompiled = 0; ///< Number of constraints of the lazy constraints compiled onto the tape
+  std::optional<size_t> conflict; ///< Constraint causing the last failure of propagation, if known
+  Statistics statistics;
+  bool complete = false;
+
+  inline size_t getRestartLimit() const {
+    if ( restarts == Restarts::LUBY ) {
+      return restartScale * luby(statistics.restarts + 1);
+    }
+    return (size_t)std::ceil( (double)restartScale * std::pow(restartFactor, (double)statistics.restarts) );
+  }
+
+  /**
+   * @brief Returns the decision of the heuristic for an input after checking that it narrows the bounds.
+   */
+  inline Literal decide(size_t input, const std::vector<Interval>& bounds) const {
+    if ( bounds[input].lowerBound == std::numeric_limits<double>::lowest() || bounds[input].upperBound == std::numeric_limits<double>::max() ) {
+      throw std::invalid_argument("CP: search requires finite bounds of variable '" + tape.getInputs()[input]->name + "'");
+    }
+    auto decision = heuristic->decide(input, bounds);
+    if ( decision.input >= bounds.size() || decision.isTrue(bounds) || decision.negation().isTrue(bounds) ) {
+      throw std::logic_error("CP: decision of heuristic does not narrow the bounds of variable '" + tape.getInputs()[input]->name + "'");
+    }
+    return decision;
+  }
+
+  /**
+   * @brief Narrows the bounds to a fixpoint of nogoods, constraints, objective bound, and sequences and returns false if the bounds become empty.
+   *
+   * Propagation stops before the fixpoint after the maximal number of rounds or when the deadline of the search is
+   * reached, e.g. for constraints narrowing large domains by one value per round. The nogoods are always propagated to
+   * their fixpoint, so that their watches remain valid.
+   *
+   * @param changed The inputs whose bounds changed since the last propagation.
+   * @param report Whether the heuristic is informed about narrowed inputs.
+   */
+  inline bool propagate(std::vector<Interval>& bounds, std::vector<size_t>& changed, bool report = true) {
+    CP_COUNT(PROPAGATIONS, 1);
+    conflict.reset();
+    size_t constraint = 0;
+    std::vector<Interval> previous;
+    for ( size_t round = 1; ; round++ ) {
+      previous = bounds;
+      if ( !nogoods.propagate(bounds, changed) ) {
+        return false;
+      }
+      if ( !analyzer.propagate(constraints, bounds, tape, &constraint) ) {
+        conflict = constraint;
+        return false;
+      }
+      for ( size_t output : lazyOutputs ) {
+        if ( !tape.narrow(output, { 0.0, 0.0 }, bounds) ) {
+          return false;
+        }
+      }
+      if ( best && !narrowObjective(bounds) ) {
+        return false;
+      }
+      if ( !propagateSequences(bounds) ) {
+        return false;
+      }
+      changed.clear();
+      for ( size_t input = 0; input < bounds.size(); input++ ) {
+        if ( bounds[input].lowerBound != previous[input].lowerBound || bounds[input].upperBound != previous[input].upperBound ) {
+          changed.push_back(input);
+          if ( report ) {
+            heuristic->narrowed(input, previous[input], bounds[input]);
+          }
+        }
+      }
+      if ( changed.empty() ) {
+        return true;
+      }
+      if ( round >= maxRounds || std::chrono::steady_clock::now() >= deadline ) {
+        return nogoods.propagate(bounds, changed);
+      }
+    }
+  }
+
+  /**
+   * @brief Narrows the bounds such that the objectives may lexicographically improve on the best solution.
+   *
+   * A single objective is narrowed to values improving on the best solution. With several objectives, an improving
+   * solution may tie on the first objective, which is therefore only narrowed to values not worse than the best
+   * solution, and the bounds are rejected if the bounds of all objectives cannot improve on the best solution.
+   */
+  inline bool narrowObjective(std::vector<Interval>& bounds) {
+    bool strict = ( senses.size() == 1 );
+    double tolerance = ( strict ? 1e-6 : -1e-6 ) * std::max(1.0, std::abs(bestObjectives.front()));
+    bool narrowed = ( sense == Model::ObjectiveSense::MINIMIZE )
+      ? tape.narrow(0, { std::numeric_limits<double>::lowest(), bestObjectives.front() - tolerance }, bounds)
+      : tape.narrow(0, { bestObjectives.front() + tolerance, std::numeric_limits<double>::max() }, bounds)
+    ;
+    if ( !narrowed || strict ) {
+      return narrowed;
+    }
+    tape.bounds(bounds);
+    objectiveBounds.resize(senses.size());
+    for ( size_t objective = 0; objective < senses.size(); objective++ ) {
+      objectiveBounds[objective] = tape.getBounds(objective);
+    }
+    return mayImprove(objectiveBounds, bestObjectives, senses);
+  }
+
+  /**
+   * @brief Removes values of fixed variables of a sequence from the bounds of the other variables.
+   */
+  inline bool propagateSequences(std::vector<Interval>& bounds) const {
+    std::vector<char> used;
+    for ( auto& sequence : sequences ) {
+      bool changed = true;
+      while ( changed ) {
+        changed = false;
+        used.assign(sequence.size() + 2, false);
+        for ( size_t input : sequence ) {
+          if ( bounds[input].lowerBound == bounds[input].upperBound ) {
+            auto& slot = used[ (size_t)std::clamp(bounds[input].lowerBound, 0.0, (double)sequence.size() + 1) ];
+            if ( slot ) {
+              return false;
+            }
+            slot = true;
+          }
+        }
+        for ( size_t input : sequence ) {
+          auto& [lowerBound, upperBound] = bounds[input];
+          if ( lowerBound == upperBound ) {
+            continue;
+          }
+          while ( lowerBound <= upperBound && used[(size_t)lowerBound] ) {
+            lowerBound++;
+          }
+          while ( lowerBound <= upperBound && used[(size_t)upperBound] ) {
+            upperBound--;
+          }
+          if ( lowerBound > upperBound ) {
+            return false;
+          }
+          changed = changed || ( lowerBound == upperBound );
+        }
+      }
+    }
+    return true;
+  }
+
+  /**
+   * @brief Returns true if the fixed inputs satisfy all constraints including lazy constraints and improve the best solution, which is updated.
+   */
+  inline bool isSolution(const std::vector<Interval>& bounds) {
+    std::vector<double> values(bounds.size());
+    for ( size_t input = 0; input < bounds.size(); input++ ) {
+      values[input] = bounds[input].lowerBound;
+    }
+    tape.forward(values);
+    for ( size_t constraint : constraints ) {
+      if ( tape.getValue(analyzer.getChecker().getOutput(constraint)) > 0.0 ) {
+        return false;
+      }
+    }
+    for ( size_t output : lazyOutputs ) {
+      if ( tape.getValue(output) > 0.0 ) {
+        return false;
+      }
+    }
+    std::vector<double> objectives(senses.size());
+    for ( size_t objective = 0; objective < senses.size(); objective++ ) {
+      objectives[objective] = tape.getValue(objective);
+    }
+    if ( lazy ) {
+      lazy->generate({ tape, values });
+      if ( compileLazyConstraints() ) {
+        return false;
+      }
+    }
+    if ( best && !isLexicographicallyBetter(objectives, bestObjectives, senses) ) {
+      return false;
+    }
+    bestObjectives = std::move(objectives);
+    best = std::move(values);
+    if ( channel ) {
+      for ( size_t input = 0; input < bounds.size(); input++ ) {
+        publication[input] = bounds[input].lowerBound;
+      }
+      publish( sense == Model::ObjectiveSense::MAXIMIZE ? std::numeric_limits<double>::max() : std::numeric_limits<double>::lowest(), false );
+    }
+    return true;
+  }
+
+  /**
+   * @brief Publishes the values in the publication buffer with the given bound to the channel, retrying while all slots are read.
+   *
+   * @param required Whether publishing is retried until it succeeds instead of a few times.
+   */
+  inline void publish(double bound, bool required) {
+    for ( size_t attempt = 1; !channel->publish(publication, bestObjectives.front(), bound); attempt++ ) {
+      if ( !required && attempt == 3 ) {
+        statistics.failedPublications++;
+        return;
+      }
+      std::this_thread::yield();
+    }
+  }
+
+  /**
+   * @brief Compiles the constraints generated since the last call, possibly by another search, onto the tape and returns true if there is any.
+   */
+  inline bool compileLazyConstraints() {
+    auto& generated = lazy->getConstraints();
+    if ( lazyCompiled == generated.size() ) {
+      return false;
+    }
+    for ( ; lazyCompiled < generated.size(); lazyCompiled++ ) {
+      auto& constraint = generated[lazyCompiled];
+      // compiling a variable which is not an input would add an input
+      std::vector<const Expression*> stack = { &constraint };
+      while ( !stack.empty() ) {
+        auto expression = stack.back();
+        stack.pop_back();
+        for ( auto& operand : expression->operands ) {
+          if ( std::holds_alternative<std::reference_wrapper<const Variable>>(operand) ) {
+            auto& variable = std::get<std::reference_wrapper<const Variable>>(operand).get();
+            if ( !tape.getInputIndex(variable) ) {
+              throw std::invalid_argument("CP: lazy constraint uses variable '" + variable.name + "' which is not an input of the search");
+            }
+          }
+          else if ( std::holds_alternative<Expression>(operand) ) {
+            stack.push_back(&std::get<Expression>(operand));
+          }
+        }
+      }
+      lazyOutputs.push_back(tape.addViolation(constraint));
+      statistics.lazyConstraints++;
+    }
+    return true;
+  }
+
+  /**
+   * @brief Marks the search as complete and publishes the best solution as optimal.
+   */
+  inline void completed() {
+    complete = true;
+    if ( channel && best ) {
+      // the buffer holds an outdated incumbent after the last publication
+      std::copy(best->begin(), best->end(), publication.begin());
+      publish(bestObjectives.front(), true);
+    }
+  }
+
+  /**
+   * @brief Appends a frame for a decision, which stores the bounds if its depth is a multiple of the snapshot interval.
+   *
+   * If the number of stored bounds reaches the limit, the interval is doubled and the bounds of the frames whose depth is
+   * no longer a multiple of the interval are released.
+   */
+  inline void pushFrame(const std::vector<Interval>& bounds, const Literal& decision) {
+    size_t depth = path.size();
+    if ( depth % snapshotInterval == 0 && snapshots >= snapshotLimit ) {
+      snapshotInterval *= 2;
+      for ( size_t i = 0; i < path.size(); i++ ) {
+        if ( i % snapshotInterval != 0 && !path[i].bounds.empty() ) {
+          path[i].bounds = std::vector<Interval>();
+          snapshots--;
+        }
+      }
+    }
+    if ( depth % snapshotInterval == 0 && snapshots < snapshotLimit ) {
+      path.push_back({ bounds, decision, false });
+      snapshots++;
+    }
+    else {
+      path.push_back({ {}, decision, false });
+    }
+    updatePeakBytes();
+  }
+
+  inline void popFrame() {
+    snapshots -= !path.back().bounds.empty();
+    path.pop_back();
+  }
+
+  inline void clearPath() {
+    path.clear();
+    snapshots = 0;
+    snapshotInterval = 1;
+  }
+
+  inline void updatePeakBytes() {
+    size_t bytes = snapshots * root.size() * sizeof(Interval) + nogoods.getLiteralCount() * sizeof(Literal);
+    statistics.peakBytes = std::max(statistics.peakBytes, bytes);
+  }
+
+  /**
+   * @brief Sets the bounds to the bounds before the decision of the last frame and returns false if they are empty.
+   *
+   * If the bounds of the last frame are not stored, they are recomputed from the nearest stored bounds, or the root, by
+   * applying and propagating the decisions, or their negations if refuted, of the frames in between. As nogoods and the
+   * objective bound may have tightened since, the recomputed bounds may be narrower than before and may even be empty.
+   * In this case the frames below the frame whose decision failed are removed, so that the last frame is the frame whose
+   * decision failed.
+   */
+  inline bool restore(std::vector<Interval>& bounds) {
+    size_t depth = path.size() - 1;
+    if ( !path[depth].bounds.empty() ) {
+      bounds = path[depth].bounds;
+      return true;
+    }
+    statistics.recomputations++;
+    size_t first = depth;
+    while ( first > 0 && path[first].bounds.empty() ) {
+      first--;
+    }
+    bounds = path[first].bounds.empty() ? root : path[first].bounds;
+    std::vector<size_t> changed;
+    for ( size_t i = first; i < depth; i++ ) {
+      auto decision = path[i].refuted ? path[i].decision.negation() : path[i].decision;
+      decision.apply(bounds);
+      changed.assign(1, decision.input);
+      if ( !propagate(bounds, changed, false) ) {
+        while ( path.size() > i + 1 ) {
+          popFrame();
+        }
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /**
+   * @brief Explores the negation of the deepest positive decision which can be propagated and returns false if there is none.
+   */
+  inline bool backtrack(std::vector<Interval>& bounds) {
+    std::vector<size_t> changed;
+    while ( !path.empty() ) {
+      auto& frame = path.back();
+      if ( frame.refuted ) {
+        popFrame();
+        continue;
+      }
+      CP_COUNT(BACKTRACKS, 1);
+      frame.refuted = true;
+      if ( !restore(bounds) ) {
+        statistics.failures++;
+        continue;
+      }
+      auto negation = path.back().decision.negation();
+      negation.apply(bounds);
+      changed.assign(1, negation.input);
+      if ( propagate(bounds, changed) ) {
+        return true;
+      }
+      heuristic->failed(conflict);
+      statistics.failures++;
+    }
+    return false;
+  }
+
+  /**
+   * @brief Records the decision-based nogoods of the current branch, i.e. each refuted decision together with all positive decisions before it.
+   */
+  inline void recordNogoods() {
+    std::vector<Literal> positive;
+    for ( auto& frame : path ) {
+      if ( frame.refuted ) {
+        auto nogood = positive;
+        nogood.push_back(frame.decision);
+        nogoods.add(std::move(nogood));
+        statistics.nogoods++;
+      }
+      else {
+        positive.push_back(frame.decision);
+      }
+    }
+    updatePeakBytes();
+    if ( nogoods.size() > nogoodLimit ) {
+      statistics.deletedNogoods += nogoods.reduce(nogoodLimit / 2);
+    }
+  }
+};
+
+} // end namespace CP
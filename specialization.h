@@ -0,0 +1,352 @@
+ /**
+ ******************************************************************************
+ *
+ *  Specialization of constraints given fixed variables
+ *
+ ******************************************************************************
+ */
+
+#pragma once
+
+#include <cmath>
+#include <algorithm>
+#include <optional>
+#include <unordered_map>
+#include <unordered_set>
+#include <stdexcept>
+
+#include "cp.h"
+#include "tape.h"
+
+namespace CP {
+
+/*******************************************
+ * Specialization
+ ******************************************/
+
+using Fixings = std::unordered_map<const Variable*, double>;
+
+/**
+ * @brief Returns a simplified expression in which all fixed variables are replaced by their values.
+ *
+ * Operations with constant operands are evaluated, conjunctions and disjunctions with a constant operand are reduced,
+ * and conditionals with constant conditions are replaced by the selected branch, i.e. dead branches are dropped. An
+ * implication `!b || e` thus becomes `e` if `b` is fixed to true and `1.00` if `b` is fixed to false. The expression
+ * is traversed without recursion. A deduced variable whose expression uses a fixed variable is replaced by its
+ * specialized expression, e.g. by the selected branch of a conditional, other deduced variables are kept.
+ */
+inline Expression specialize(const Expression& expression, const Fixings& fixings) {
+  constexpr auto none = Expression::Operator::none;
+  auto isConstant = [](const Operand& operand) { return std::holds_alternative<double>(operand); };
+  auto constant = [](const Operand& operand) { return std::get<double>(operand); };
+  // a truth value is 0 or 1, so that it can replace a conjunction or disjunction with a constant operand
+  auto isTruthValue = [](const Operand& operand) {
+    if ( std::holds_alternative<std::reference_wrapper<const Variable>>(operand) ) {
+      return std::get<std::reference_wrapper<const Variable>>(operand).get().type == Variable::Type::BOOLEAN;
+    }
+    if ( std::holds_alternative<Expression>(operand) ) {
+      auto _operator = std::get<Expression>(operand)._operator;
+      return _operator == Expression::Operator::logical_not || _operator == Expression::Operator::logical_and || _operator == Expression::Operator::logical_or
+        || ( _operator >= Expression::Operator::less_than && _operator <= Expression::Operator::not_equal );
+    }
+    return std::holds_alternative<double>(operand) && ( std::get<double>(operand) == 0.0 || std::get<double>(operand) == 1.0 );
+  };
+
+  // simplifies a node given its simplified operands
+  auto simplify = [&](const Expression& node, std::vector<Operand>&& operands) -> Operand {
+    using Operator = Expression::Operator;
+    auto fold = [&](size_t i, size_t j) { return isConstant(operands[i]) && isConstant(operands[j]); };
+    switch ( node._operator ) {
+      case Operator::none:
+        return std::move(operands[0]);
+      case Operator::negate:
+        if ( isConstant(operands[0]) ) return -constant(operands[0]);
+        break;
+      case Operator::logical_not:
+        if ( isConstant(operands[0]) ) return (double)!constant(operands[0]);
+        break;
+      case Operator::logical_and:
+      case Operator::logical_or:
+      {
+        // the dominant value determines the result, the other operand is returned if the other value is constant
+        bool dominant = ( node._operator == Operator::logical_or );
+        for ( size_t i = 0; i < 2; i++ ) {
+          if ( isConstant(operands[i]) && ( constant(operands[i]) != 0.0 ) == dominant ) {
+            return (double)dominant;
+          }
+        }
+        for ( size_t i = 0; i < 2; i++ ) {
+          if ( isConstant(operands[i]) && isTruthValue(operands[1-i]) ) {
+            return std::move(operands[1-i]);
+          }
+        }
+        break;
+      }
+      case Operator::add: if ( fold(0,1) ) return constant(operands[0]) + constant(operands[1]); break;
+      case Operator::subtract: if ( fold(0,1) ) return constant(operands[0]) - constant(operands[1]); break;
+      case Operator::multiply: if ( fold(0,1) ) return constant(operands[0]) * constant(operands[1]); break;
+      case Operator::divide: if ( fold(0,1) ) return constant(operands[0]) / constant(operands[1]); break;
+      case Operator::less_than: if ( fold(0,1) ) return (double)( constant(operands[0]) < constant(operands[1]) ); break;
+      case Operator::less_or_equal: if ( fold(0,1) ) return (double)( constant(operands[0]) <= constant(operands[1]) ); break;
+      case Operator::greater_than: if ( fold(0,1) ) return (double)( constant(operands[0]) > constant(operands[1]) ); break;
+      case Operator::greater_or_equal: if ( fold(0,1) ) return (double)( constant(operands[0]) >= constant(operands[1]) ); break;
+      case Operator::equal: if ( fold(0,1) ) return (double)( constant(operands[0]) == constant(operands[1]) ); break;
+      case Operator::not_equal: if ( fold(0,1) ) return (double)( constant(operands[0]) != constant(operands[1]) ); break;
+      case Operator::custom:
+      {
+        auto& name = Expression::customOperators[std::get<size_t>(operands[0])];
+        if ( name == "if_then_else" && isConstant(operands[1]) ) {
+          return std::move(operands[ constant(operands[1]) ? 2 : 3 ]);
+        }
+        if ( name == "n_ary_if" ) {
+          // drop cases with false condition and all cases after a true condition
+          std::vector<Operand> remaining = { std::move(operands[0]) };
+          size_t i = 1;
+          for ( ; i + 1 < operands.size(); i += 2 ) {
+            if ( isConstant(operands[i]) && constant(operands[i]) == 0.0 ) {
+              continue;
+            }
+            if ( isConstant(operands[i]) ) {
+              break;
+            }
+            remaining.push_back(std::move(operands[i]));
+            remaining.push_back(std::move(operands[i+1]));
+          }
+          Operand selected = std::move( operands[ i + 1 < operands.size() ? i + 1 : operands.size() - 1 ] );
+          if ( remaining.size() == 1 ) {
+            return selected;
+          }
+          remaining.push_back(std::move(selected));
+          return Expression(Operator::custom, std::move(remaining));
+        }
+        if ( ( name == "min" || name == "max" ) && std::all_of(operands.begin() + 1, operands.end(), isConstant) ) {
+          double result = constant(operands[1]);
+          for ( size_t i = 2; i < operands.size(); i++ ) {
+            result = ( name == "min" ) ? std::min(result, constant(operands[i])) : std::max(result, constant(operands[i]));
+          }
+          return result;
+        }
+        break;
+      }
+    }
+    return Expression(node._operator, std::move(operands));
+  };
+
+  struct Frame {
+    const Expression* expression;
+    size_t next; ///< Next operand to be simplified
+    size_t base; ///< Size of the result stack when the frame was created
+    const Variable* deduced = nullptr; ///< Deduced variable whose expression is simplified, if any
+    bool changed = false; ///< Whether a fixed variable is used by the expression
+  };
+  // result of each deduced variable and whether it differs from the variable, as a variable may be referenced repeatedly
+  std::unordered_map< const Variable*, std::pair<Operand, bool> > deduced;
+  std::vector<Frame> frames = { { &expression, 0, 0 } };
+  std::vector<Operand> results;
+  while ( !frames.empty() ) {
+    auto& frame = frames.back();
+    auto& operands = frame.expression->operands;
+    if ( frame.next < operands.size() ) {
+      auto& operand = operands[frame.next++];
+      if ( std::holds_alternative<Expression>(operand) ) {
+        frames.push_back({ &std::get<Expression>(operand), 0, results.size() });
+      }
+      else if ( std::holds_alternative<std::reference_wrapper<const Variable>>(operand) ) {
+        auto& variable = std::get<std::reference_wrapper<const Variable>>(operand).get();
+        if ( auto it = fixings.find(&variable); it != fixings.end() ) {
+          results.push_back(it->second);
+          frame.changed = true;
+        }
+        else if ( auto it = deduced.find(&variable); it != deduced.end() ) {
+          results.push_back(it->second.first);
+          frame.changed = frame.changed || it->second.second;
+        }
+        else if ( variable.deducedFrom ) {
+          frames.push_back({ variable.deducedFrom.get(), 0, results.size(), &variable });
+        }
+        else {
+          results.push_back(operand);
+        }
+      }
+      else {
+        results.push_back(operand);
+      }
+      continue;
+    }
+    std::vector<Operand> simplified( std::make_move_iterator(results.begin() + (long)frame.base), std::make_move_iterator(results.end()) );
+    results.resize(frame.base);
+    Operand result = simplify(*frame.expression, std::move(simplified));
+    auto variable = frame.deduced;
+    bool changed = frame.changed;
+    frames.pop_back();
+    if ( variable ) {
+      if ( !changed ) {
+        result = std::cref(*variable);
+      }
+      deduced.emplace(variable, std::make_pair(result, changed));
+    }
+    if ( changed && !frames.empty() ) {
+      frames.back().changed = true;
+    }
+    results.push_back(std::move(result));
+  }
+
+  auto& result = results.back();
+  if ( std::holds_alternative<Expression>(result) ) {
+    return std::move(std::get<Expression>(result));
+  }
+  return Expression(none, { std::move(result) });
+}
+
+/*******************************************
+ * Specializer
+ ******************************************/
+
+/**
+ * @brief Maintains specialized views of the constraints of a model for the currently fixed variables.
+ *
+ * A view is created when it is requested and kept until a variable used by the constraint is fixed or released. A
+ * constraint uses the variables of the expressions of the deduced variables it uses. That a constraint uses no fixed
+ * variable is cached in the same way, so that the constraint is not scanned again until a variable it uses is fixed.
+ *
+ * The views are evaluated by compiling them onto a tape, see compile(), whose inputs are only the variables which are
+ * not fixed. The Search does not use the views, as it fixes variables by narrowing bounds during propagation rather
+ * than by fixings, hence a caller fixing variables, e.g. a large neighbourhood search, compiles the views itself.
+ */
+class Specializer {
+public:
+  inline Specializer(const Model& model) {
+    for ( auto& constraint : model.getConstraints() ) {
+      constraints.push_back(&constraint);
+    }
+    views.resize(constraints.size());
+    unaffected.resize(constraints.size());
+    // constraints using each variable
+    std::vector<const Expression*> stack;
+    std::unordered_set<const Variable*> used;
+    for ( size_t constraint = 0; constraint < constraints.size(); constraint++ ) {
+      used.clear();
+      stack.push_back(constraints[constraint]);
+      while ( !stack.empty() ) {
+        auto expression = stack.back();
+        stack.pop_back();
+        for ( auto& operand : expression->operands ) {
+          if ( std::holds_alternative<Expression>(operand) ) {
+            stack.push_back(&std::get<Expression>(operand));
+          }
+          else if ( std::holds_alternative<std::reference_wrapper<const Variable>>(operand) ) {
+            auto variable = &std::get<std::reference_wrapper<const Variable>>(operand).get();
+            if ( used.insert(variable).second ) {
+              usage[variable].push_back(constraint);
+              if ( variable->deducedFrom ) {
+                stack.push_back(variable->deducedFrom.get());
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+
+  inline size_t size() const { return constraints.size(); };
+
+  /**
+   * @brief Fixes a variable to a value and invalidates the views of all constraints using it.
+   */
+  inline void fix(const Variable& variable, double value) {
+    if ( auto it = fixings.find(&variable); it != fixings.end() && it->second == value ) {
+      return;
+    }
+    fixings[&variable] = value;
+    invalidate(variable);
+  }
+
+  /**
+   * @brief Releases a fixed variable and invalidates the views of all constraints using it.
+   */
+  inline void release(const Variable& variable) {
+    if ( fixings.erase(&variable) ) {
+      invalidate(variable);
+    }
+  }
+
+  inline const Fixings& getFixings() const { return fixings; };
+
+  /**
+   * @brief Returns the specialized view of a constraint, or the constraint itself if it uses no fixed variable.
+   */
+  inline const Expression& getConstraint(size_t constraint) {
+    auto& view = views.at(constraint);
+    if ( unaffected[constraint] ) {
+      return *constraints[constraint];
+    }
+    if ( !view ) {
+      if ( !std::ranges::any_of(fixings, [&](auto& fixing) { return isUsed(*fixing.first, constraint); }) ) {
+        unaffected[constraint] = true;
+        return *constraints[constraint];
+      }
+      view = specialize(*constraints[constraint], fixings);
+      specializations++;
+    }
+    return view.value();
+  }
+
+  /**
+   * @brief Returns true if the constraint is satisfied for all values of the variables not fixed.
+   */
+  inline bool isRedundant(size_t constraint) {
+    auto& view = getConstraint(constraint);
+    return view._operator == Expression::Operator::none && std::holds_alternative<double>(view.operands[0]) && std::get<double>(view.operands[0]) != 0.0;
+  }
+
+  /**
+   * @brief Returns true if the constraint is violated for all values of the variables not fixed.
+   */
+  inline bool isViolated(size_t constraint) {
+    auto& view = getConstraint(constraint);
+    return view._operator == Expression::Operator::none && std::holds_alternative<double>(view.operands[0]) && std::get<double>(view.operands[0]) == 0.0;
+  }
+
+  /**
+   * @brief Compiles the views of all constraints onto a tape whose outputs are the violations of the constraints.
+   *
+   * The tape has no inputs for the fixed variables and no nodes for dead branches and redundant parts of the
+   * constraints, hence evaluating it is cheaper than evaluating the constraints of the model.
+   */
+  inline Tape compile() {
+    Tape tape;
+    for ( size_t constraint = 0; constraint < constraints.size(); constraint++ ) {
+      tape.addViolation(getConstraint(constraint));
+    }
+    return tape;
+  }
+
+  /**
+   * @brief Returns the number of views created so far.
+   */
+  inline size_t getSpecializations() const { return specializations; };
+
+private:
+  std::vector<const Expression*> constraints;
+  std::vector< std::optional<Expression> > views;
+  std::vector<bool> unaffected; ///< Whether a constraint is known to use no fixed variable
+  std::unordered_map< const Variable*, std::vector<size_t> > usage;
+  Fixings fixings;
+  size_t specializations = 0;
+
+  inline bool isUsed(const Variable& variable, size_t constraint) const {
+    auto it = usage.find(&variable);
+    return it != usage.end() && std::ranges::binary_search(it->second, constraint);
+  }
+
+  inline void invalidate(const Variable& variable) {
+    if ( auto it = usage.find(&variable); it != usage.end() ) {
+      for ( size_t constraint : it->second ) {
+        views[constraint].reset();
+        unaffected[constraint] = false;
+      }
+    }
+  }
+};
+
+} // end namespace CP
@@ -0,0 +1,421 @@
+ /**
+ ******************************************************************************
+ *
+ *  Symmetry detection and symmetry breaking
+ *
+ ******************************************************************************
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <numeric>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+
+#include "cp.h"
+
+namespace CP {
+
+/*******************************************
+ * SymmetryDetector
+ ******************************************/
+
+/**
+ * @brief Determines permutations of the variables of a model which map the model onto itself.
+ *
+ * The model is represented by a colored graph with a vertex for each variable, expression node, constant, constraint,
+ * table, sequence, and objective. Colors encode types, bounds, operators, constants, coefficients, and weights, but no
+ * names. Arcs are labeled by the position of the operand unless the operator is commutative, and nested sums, products,
+ * conjunctions, and disjunctions are flattened, so that `x + y + z` is symmetric in all variables.
+ *
+ * Generators of the automorphism group are determined by color refinement: for pairs of variables with equal stable
+ * color, both variables are individualized and the colors are refined until all colors are unique, individualizing
+ * further vertices of equal color if required. Each resulting mapping is verified to be an automorphism of the graph,
+ * hence each generator is a symmetry of the model. As no backtracking is performed, not all symmetries may be found.
+ */
+class SymmetryDetector {
+public:
+  /**
+   * @param maxAttempts The maximal number of pairs of variables for which an automorphism is searched.
+   */
+  inline SymmetryDetector(const Model& model, size_t maxAttempts = 1000) {
+    CP_TRACE_SCOPE("SymmetryDetector::SymmetryDetector");
+    build(model);
+    detect(maxAttempts);
+  }
+
+  /**
+   * @brief Returns all variables of the model in the order used by the generators and by the lexicographic order.
+   */
+  inline const std::vector<const Variable*>& getVariables() const { return variables; };
+
+  /**
+   * @brief Returns the generators, each given by the pairs of indices of a moved variable and its image.
+   */
+  inline const std::vector< std::vector< std::pair<size_t,size_t> > >& getGenerators() const { return generators; };
+
+  /**
+   * @brief Returns the orbits of the group generated by the generators containing more than one variable.
+   *
+   * Variables in the same orbit are interchangeable, e.g. a search may branch on only one variable of each orbit.
+   */
+  inline std::vector< std::vector<const Variable*> > getOrbits() const {
+    std::vector<size_t> parent(variables.size());
+    std::iota(parent.begin(), parent.end(), 0);
+    for ( auto& generator : generators ) {
+      for ( auto [variable, image] : generator ) {
+        parent[find(parent, variable)] = find(parent, image);
+      }
+    }
+    std::unordered_map<size_t, size_t> orbitIndex;
+    std::vector< std::vector<const Variable*> > orbits;
+    for ( size_t variable = 0; variable < variables.size(); variable++ ) {
+      auto [it, inserted] = orbitIndex.try_emplace(find(parent, variable), orbits.size());
+      if ( inserted ) {
+        orbits.emplace_back();
+      }
+      orbits[it->second].push_back(variables[variable]);
+    }
+    std::erase_if(orbits, [](auto& orbit) { return orbit.size() < 2; });
+    return orbits;
+  }
+
+  /**
+   * @brief Adds a symmetry-breaking constraint for each generator and returns the number of constraints added.
+   *
+   * For a generator g and the first variable x moved by g, the constraint x <= g(x) is added. It is implied by the
+   * lexicographic leader constraint requiring that the solution is not lexicographically larger than its image under g,
+   * so that the lexicographically smallest solution of each class of symmetric solutions remains feasible.
+   */
+  inline size_t addSymmetryBreakingConstraints(Model& model) const {
+    for ( auto& generator : generators ) {
+      auto [variable, image] = generator.front();
+      model.addConstraint( *variables[variable] <= *variables[image] );
+    }
+    return generators.size();
+  }
+
+private:
+  struct Arc {
+    size_t vertex;
+    uint64_t label; ///< Label including the direction of the arc
+  };
+  std::vector<uint64_t> colors; ///< Initial color of each vertex
+  std::vector< std::vector<Arc> > arcs;
+  std::vector<const Variable*> variables; ///< Variables, which are the first vertices of the graph
+  std::unordered_map<const Variable*, size_t> vertices;
+  std::vector< std::vector< std::pair<size_t,size_t> > > generators;
+
+  inline static uint64_t combine(uint64_t seed, uint64_t value) {
+    // splitmix64 finalizer applied to the combined value
+    uint64_t hash = seed ^ ( value + 0x9e3779b97f4a7c15ULL + ( seed << 6 ) + ( seed >> 2 ) );
+    hash = ( hash ^ ( hash >> 30 ) ) * 0xbf58476d1ce4e5b9ULL;
+    hash = ( hash ^ ( hash >> 27 ) ) * 0x94d049bb133111ebULL;
+    return hash ^ ( hash >> 31 );
+  }
+
+  inline static uint64_t hash(std::string_view text) { return std::hash<std::string_view>{}(text); };
+  inline static uint64_t hash(double value) { return std::bit_cast<uint64_t>( value == 0.0 ? 0.0 : value ); };
+
+  inline static size_t find(std::vector<size_t>& parent, size_t element) {
+    while ( parent[element] != element ) {
+      element = parent[element] = parent[parent[element]];
+    }
+    return element;
+  }
+
+  inline size_t addVertex(uint64_t color) {
+    colors.push_back(color);
+    arcs.emplace_back();
+    return colors.size() - 1;
+  }
+
+  inline void addArc(size_t from, size_t to, uint64_t label) {
+    arcs[from].push_back({ to, combine(label, 0) });
+    arcs[to].push_back({ from, combine(label, 1) });
+  }
+
+  inline void addVariable(const Variable& variable) {
+    vertices[&variable] = addVertex( combine( combine( combine( hash("variable"), (uint64_t)variable.type ), hash(variable.lowerBound) ), combine( hash(variable.upperBound), variable.deducedFrom != nullptr ) ) );
+    variables.push_back(&variable);
+  }
+
+  inline static bool isCommutative(const Expression& expression) {
+    using Operator = Expression::Operator;
+    if ( expression._operator == Operator::custom ) {
+      auto& name = Expression::customOperators[std::get<size_t>(expression.operands[0])];
+      return name == "min" || name == "max";
+    }
+    return expression._operator == Operator::add || expression._operator == Operator::multiply
+      || expression._operator == Operator::logical_and || expression._operator == Operator::logical_or
+      || expression._operator == Operator::equal || expression._operator == Operator::not_equal;
+  }
+
+  inline static uint64_t getColor(const Expression& expression) {
+    uint64_t color = combine( hash("expression"), (uint64_t)expression._operator );
+    if ( expression._operator == Expression::Operator::custom ) {
+      color = combine( color, hash(Expression::customOperators[std::get<size_t>(expression.operands[0])]) );
+    }
+    return color;
+  }
+
+  /**
+   * @brief Adds the vertices and arcs of an expression and returns the vertex of its root.
+   */
+  inline size_t addExpression(const Expression& expression) {
+    using Operator = Expression::Operator;
+    size_t root = addVertex( getColor(expression) );
+    std::vector< std::pair<const Expression*, size_t> > stack = { { &expression, root } };
+    while ( !stack.empty() ) {
+      auto [node, vertex] = stack.back();
+      stack.pop_back();
+      bool commutative = isCommutative(*node);
+      for ( size_t i = ( node->_operator == Operator::custom ); i < node->operands.size(); i++ ) {
+        auto& operand = node->operands[i];
+        uint64_t label = commutative ? 0 : i + 1;
+        if ( std::holds_alternative<double>(operand) ) {
+          addArc( vertex, addVertex( combine( hash("constant"), hash(std::get<double>(operand)) ) ), label );
+        }
+        else if ( std::holds_alternative<std::reference_wrapper<const Variable>>(operand) ) {
+          addArc( vertex, vertices.at( &std::get<std::reference_wrapper<const Variable>>(operand).get() ), label );
+        }
+        else if ( std::holds_alternative<Expression>(operand) ) {
+          auto& child = std::get<Expression>(operand);
+          // flatten nested associative operations
+          bool associative = ( child._operator == node->_operator ) && node->_operator != Operator::custom
+            && node->_operator != Operator::equal && node->_operator != Operator::not_equal;
+          if ( commutative && associative ) {
+            stack.push_back({ &child, vertex });
+          }
+          else {
+            size_t childVertex = addVertex( getColor(child) );
+            addArc( vertex, childVertex, label );
+            stack.push_back({ &child, childVertex });
+          }
+        }
+      }
+    }
+    return root;
+  }
+
+  inline void build(const Model& model) {
+    for ( auto& variable : model.getVariables() ) {
+      addVariable(variable);
+    }
+    for ( auto& indexedVariables : model.getIndexedVariables() ) {
+      for ( size_t i = 0; i < indexedVariables.size(); i++ ) {
+        addVariable(indexedVariables[i]);
+      }
+    }
+    for ( auto& sequence : model.getSequences() ) {
+      for ( const Variable& variable : sequence.variables ) {
+        addVariable(variable);
+      }
+    }
+    for ( auto variable : std::vector<const Variable*>(variables) ) {
+      if ( variable->deducedFrom ) {
+        addArc( vertices.at(variable), addExpression(*variable->deducedFrom), hash("deduced") );
+      }
+    }
+
+    for ( auto& sequence : model.getSequences() ) {
+      size_t vertex = addVertex( combine( hash("sequence"), sequence.variables.size() ) );
+      for ( const Variable& variable : sequence.variables ) {
+        addArc( vertex, vertices.at(&variable), 0 );
+      }
+    }
+    size_t rank = 0;
+    for ( auto& objective : model.getObjectives() ) {
+      if ( !objective.expression.operands.empty() ) {
+        size_t vertex = addVertex( combine( combine( hash("objective"), (uint64_t)objective.sense ), rank ) );
+        addArc( vertex, addExpression(objective.expression), 0 );
+      }
+      rank++;
+    }
+    for ( auto& constraint : model.getConstraints() ) {
+      addArc( addVertex( hash("constraint") ), addExpression(constraint), 0 );
+    }
+    auto addLinearConstraint = [&](const LinearConstraint& constraint) {
+      size_t vertex = addVertex( combine( combine( hash("linear"), (uint64_t)constraint._operator ), hash(constraint.rhs) ) );
+      for ( size_t i = 0; i < constraint.variables.size(); i++ ) {
+        addArc( vertex, vertices.at(&constraint.variables[i]), hash(constraint.coefficients[i]) );
+      }
+      return vertex;
+    };
+    for ( auto& constraint : model.getLinearConstraints() ) {
+      addLinearConstraint(constraint);
+    }
+    for ( auto& constraint : model.getSoftConstraints() ) {
+      size_t vertex = addVertex( combine( combine( hash("soft"), hash(constraint.weight) ), constraint.priority ) );
+      if ( std::holds_alternative<Expression>(constraint.constraint) ) {
+        addArc( vertex, addExpression(std::get<Expression>(constraint.constraint)), 0 );
+      }
+      else {
+        addArc( vertex, addLinearConstraint(std::get<LinearConstraint>(constraint.constraint)), 0 );
+      }
+    }
+    for ( auto& table : model.getTables() ) {
+      // the tuples are identified by their exact values in row order
+      uint64_t color = combine( hash("table"), (uint64_t)table.type );
+      for ( size_t row = 0; row < table.size(); row++ ) {
+        for ( size_t column = 0; column < table.arity(); column++ ) {
+          color = combine( color, hash(table.value(row, column)) );
+        }
+      }
+      size_t vertex = addVertex(color);
+      for ( size_t i = 0; i < table.variables.size(); i++ ) {
+        addArc( vertex, vertices.at(&table.variables[i]), i + 1 );
+      }
+    }
+  }
+
+  inline static size_t countColors(const std::vector<uint64_t>& coloring) {
+    auto sorted = coloring;
+    std::sort(sorted.begin(), sorted.end());
+    return (size_t)( std::unique(sorted.begin(), sorted.end()) - sorted.begin() );
+  }
+
+  /**
+   * @brief Refines the coloring until vertices with equal color have the same number of neighbors of each color.
+   */
+  inline std::vector<uint64_t> refine(std::vector<uint64_t> coloring) const {
+    size_t classes = countColors(coloring);
+    std::vector<uint64_t> refined(coloring.size());
+    std::vector< std::pair<uint64_t,uint64_t> > signature;
+    while ( true ) {
+      for ( size_t vertex = 0; vertex < coloring.size(); vertex++ ) {
+        signature.clear();
+        for ( auto& arc : arcs[vertex] ) {
+          signature.push_back({ arc.label, coloring[arc.vertex] });
+        }
+        std::sort(signature.begin(), signature.end());
+        uint64_t color = coloring[vertex];
+        for ( auto [label, neighbor] : signature ) {
+          color = combine( combine(color, label), neighbor );
+        }
+        refined[vertex] = color;
+      }
+      std::swap(coloring, refined);
+      size_t refinedClasses = countColors(coloring);
+      if ( refinedClasses == classes ) {
+        return coloring;
+      }
+      classes = refinedClasses;
+    }
+  }
+
+  /**
+   * @brief Returns true if the permutation of the vertices preserves colors and arcs.
+   */
+  inline bool isAutomorphism(const std::vector<size_t>& permutation) const {
+    std::vector< std::pair<uint64_t,size_t> > mapped, image;
+    for ( size_t vertex = 0; vertex < permutation.size(); vertex++ ) {
+      size_t target = permutation[vertex];
+      if ( colors[vertex] != colors[target] || arcs[vertex].size() != arcs[target].size() ) {
+        return false;
+      }
+      mapped.clear();
+      image.clear();
+      for ( size_t i = 0; i < arcs[vertex].size(); i++ ) {
+        mapped.push_back({ arcs[vertex][i].label, permutation[arcs[vertex][i].vertex] });
+        image.push_back({ arcs[target][i].label, arcs[target][i].vertex });
+      }
+      std::sort(mapped.begin(), mapped.end());
+      std::sort(image.begin(), image.end());
+      if ( mapped != image ) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /**
+   * @brief Returns an automorphism mapping the first to the second vertex, if found without backtracking.
+   */
+  inline std::optional< std::vector<size_t> > findAutomorphism(size_t from, size_t to, const std::vector<uint64_t>& stable) const {
+    auto coloring = stable;
+    auto target = stable;
+    std::vector< std::pair<uint64_t,size_t> > classes, targetClasses;
+    for ( uint64_t individualization = 1; ; individualization++ ) {
+      coloring[from] = target[to] = combine( coloring[from], combine( hash("individualized"), individualization ) );
+      coloring = refine(std::move(coloring));
+      target = refine(std::move(target));
+
+      classes.clear();
+      targetClasses.clear();
+      for ( size_t vertex = 0; vertex < coloring.size(); vertex++ ) {
+        classes.push_back({ coloring[vertex], vertex });
+        targetClasses.push_back({ target[vertex], vertex });
+      }
+      std::sort(classes.begin(), classes.end());
+      std::sort(targetClasses.begin(), targetClasses.end());
+      for ( size_t i = 0; i < classes.size(); i++ ) {
+        if ( classes[i].first != targetClasses[i].first ) {
+          return std::nullopt;
+        }
+      }
+
+      // individualize the first vertex of the first color class which is not a singleton
+      auto it = std::adjacent_find(classes.begin(), classes.end(), [](auto& lhs, auto& rhs) { return lhs.first == rhs.first; });
+      if ( it != classes.end() ) {
+        from = it->second;
+        to = targetClasses[ (size_t)( it - classes.begin() ) ].second;
+        continue;
+      }
+      std::vector<size_t> permutation(coloring.size());
+      for ( size_t i = 0; i < classes.size(); i++ ) {
+        permutation[classes[i].second] = targetClasses[i].second;
+      }
+      if ( !isAutomorphism(permutation) ) {
+        return std::nullopt;
+      }
+      return permutation;
+    }
+  }
+
+  inline void detect(size_t maxAttempts) {
+    auto stable = refine(colors);
+    // candidate variables grouped by stable color
+    std::vector< std::pair<uint64_t,size_t> > candidates;
+    for ( size_t variable = 0; variable < variables.size(); variable++ ) {
+      candidates.push_back({ stable[variable], variable });
+    }
+    std::sort(candidates.begin(), candidates.end());
+
+    std::vector<size_t> parent(variables.size());
+    std::iota(parent.begin(), parent.end(), 0);
+    size_t attempts = 0;
+    for ( size_t begin = 0, end = 0; begin < candidates.size(); begin = end ) {
+      while ( end < candidates.size() && candidates[end].first == candidates[begin].first ) {
+        end++;
+      }
+      for ( size_t i = begin; i < end; i++ ) {
+        for ( size_t j = i + 1; j < end && attempts < maxAttempts; j++ ) {
+          size_t from = candidates[i].second;
+          size_t to = candidates[j].second;
+          if ( find(parent, from) == find(parent, to) ) {
+            continue;
+          }
+          attempts++;
+          auto automorphism = findAutomorphism(from, to, stable);
+          if ( !automorphism ) {
+            continue;
+          }
+          std::vector< std::pair<size_t,size_t> > generator;
+          for ( size_t variable = 0; variable < variables.size(); variable++ ) {
+            if ( (*automorphism)[variable] != variable ) {
+              generator.push_back({ variable, (*automorphism)[variable] });
+              parent[find(parent, variable)] = find(parent, (*automorphism)[variable]);
+            }
+          }
+          generators.push_back(std::move(generator));
+        }
+      }
+    }
+  }
+};
+
+} // end namespace CP
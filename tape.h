@@ -0,0 +1,1265 @@
+ /**
+ ******************************************************************************
+ *
+ *  Compiled postfix form of expressions with reverse-mode differentiation
+ *
+ ******************************************************************************
+ */
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+#include <optional>
+#include <tuple>
+#include <unordered_map>
+#include <stdexcept>
+
+#include "cp.h"
+
+namespace CP {
+
+/*******************************************
+ * Tape
+ ******************************************/
+
+/**
+ * @brief Represents a collection of expressions compiled into a flat array of nodes in postfix order.
+ *
+ * Each node refers to its arguments by index, all arguments precede the node. Variables which are
+ * deduced from an expression are inlined and compiled only once, all other variables are inputs
+ * of the tape. After a forward sweep computing the node values, a single backward sweep provides
+ * the gradient of a weighted sum of the outputs with respect to the inputs.
+ */
+class Tape {
+public:
+  enum class Opcode {
+    constant,
+    input,
+    negate,
+    logical_not,
+    logical_and,
+    logical_or,
+    add,
+    subtract,
+    multiply,
+    divide,
+    less_than,
+    less_or_equal,
+    greater_than,
+    greater_or_equal,
+    equal,
+    not_equal,
+    min,
+    max,
+    if_then_else,
+    n_ary_if,
+    pow,
+    sqrt,
+    cbrt,
+    piecewise_linear,
+    step,
+    table,
+    linear,
+    positive_part,
+    absolute
+  };
+
+  struct Node {
+    Opcode opcode;
+    size_t first; ///< Position of the first argument in the argument array
+    size_t count; ///< Number of arguments
+    double constant; ///< Value of a constant, position of an input, or position of the breakpoints
+  };
+
+  using Interval = CP::Interval;
+
+  /**
+   * @brief Represents an entry of a sparse matrix.
+   */
+  struct Entry {
+    size_t row;
+    size_t column;
+    double value;
+  };
+
+  inline Tape() = default;
+
+  /**
+   * @brief Compiles the objectives in lexicographic order (outputs 0, ..., k-1), the violations of all constraints (outputs k, ..., k+n-1),
+   * followed by the violations of all tables, the violations of all linear constraints, and the unweighted violations of all soft constraints of a model.
+   */
+  inline Tape(const Model& model) {
+    CP_TRACE_SCOPE("Tape::Tape");
+    for ( auto& objective : model.getObjectives() ) {
+      addOutput(objective.expression);
+    }
+    for ( auto& constraint : model.getConstraints() ) {
+      addViolation(constraint);
+    }
+    for ( auto& table : model.getTables() ) {
+      addViolation(table);
+    }
+    for ( auto& constraint : model.getLinearConstraints() ) {
+      addViolation(constraint);
+    }
+    for ( auto& constraint : model.getSoftConstraints() ) {
+      addViolation(constraint);
+    }
+  }
+
+  /**
+   * @brief Compiles an expression and adds its value as output of the tape.
+   *
+   * @returns The index of the output.
+   */
+  inline size_t addOutput(const Expression& expression) {
+    outputs.push_back( compile(expression) );
+    return outputs.size() - 1;
+  }
+
+  /**
+   * @brief Compiles a constraint and adds its violation as output of the tape.
+   *
+   * The violation of `lhs <= rhs` and `lhs < rhs` is `max(0, lhs - rhs)`, the violation of `lhs >= rhs` and `lhs > rhs`
+   * is `max(0, rhs - lhs)`, the violation of `lhs == rhs` is `|lhs - rhs|`. All other constraints have violation 1 if
+   * they are not satisfied and 0 otherwise.
+   *
+   * @returns The index of the output.
+   */
+  inline size_t addViolation(const Expression& constraint) {
+    auto difference = [&](const Operand& lhs, const Operand& rhs) {
+      return emit(Opcode::subtract, { compile(lhs), compile(rhs) });
+    };
+
+    size_t root;
+    switch ( constraint._operator ) {
+      case Expression::Operator::less_than:
+      case Expression::Operator::less_or_equal:
+        root = emit(Opcode::positive_part, { difference(constraint.operands[0], constraint.operands[1]) });
+        break;
+      case Expression::Operator::greater_than:
+      case Expression::Operator::greater_or_equal:
+        root = emit(Opcode::positive_part, { difference(constraint.operands[1], constraint.operands[0]) });
+        break;
+      case Expression::Operator::equal:
+        root = emit(Opcode::absolute, { difference(constraint.operands[0], constraint.operands[1]) });
+        break;
+      default:
+        root = emit(Opcode::logical_not, { compile(constraint) });
+    }
+    outputs.push_back(root);
+    return outputs.size() - 1;
+  }
+
+  /**
+   * @brief Adds the violation of a table as output of the tape, which is 1 if the table constraint is not satisfied and 0 otherwise.
+   *
+   * @returns The index of the output.
+   */
+  inline size_t addViolation(const Table& table) {
+    std::vector<size_t> columns;
+    columns.reserve(table.arity());
+    for ( const Variable& variable : table.variables ) {
+      columns.push_back( compile(std::cref(variable)) );
+    }
+    tables.push_back(&table);
+    size_t root = emit(Opcode::table, columns, (double)(tables.size() - 1));
+    outputs.push_back( emit(Opcode::logical_not, { root }) );
+    return outputs.size() - 1;
+  }
+
+  /**
+   * @brief Adds the violation of a linear constraint as output of the tape, which is measured like for the respective comparison.
+   *
+   * @returns The index of the output.
+   */
+  inline size_t addViolation(const LinearConstraint& constraint) {
+    std::vector<size_t> terms;
+    terms.reserve(constraint.variables.size());
+    for ( const Variable& variable : constraint.variables ) {
+      terms.push_back( compile(std::cref(variable)) );
+    }
+    linears.push_back(&constraint);
+    size_t lhs = emit(Opcode::linear, terms, (double)(linears.size() - 1));
+    size_t rhs = emit(Opcode::constant, {}, constraint.rhs);
+    switch ( constraint._operator ) {
+      case Expression::Operator::less_or_equal:
+        outputs.push_back( emit(Opcode::positive_part, { emit(Opcode::subtract, { lhs, rhs }) }) );
+        break;
+      case Expression::Operator::greater_or_equal:
+        outputs.push_back( emit(Opcode::positive_part, { emit(Opcode::subtract, { rhs, lhs }) }) );
+        break;
+      default:
+        outputs.push_back( emit(Opcode::absolute, { emit(Opcode::subtract, { lhs, rhs }) }) );
+    }
+    return outputs.size() - 1;
+  }
+
+  /**
+   * @brief Adds the unweighted violation of a soft constraint as output of the tape.
+   *
+   * @returns The index of the output.
+   */
+  inline size_t addViolation(const SoftConstraint& constraint) {
+    return std::visit( [this](const auto& hardConstraint) { return addViolation(hardConstraint); }, constraint.constraint );
+  }
+
+  inline const std::vector<Node>& getNodes() const { return nodes; };
+  inline const std::vector<size_t>& getArguments() const { return arguments; };
+  inline const std::vector<size_t>& getOutputs() const { return outputs; };
+
+  /**
+   * @brief Returns the variables used as inputs, the values provided to forward() must be given in this order.
+   */
+  inline const std::vector<const Variable*>& getInputs() const { return inputs; };
+
+  /**
+   * @brief Returns the position of a variable among the inputs or std::nullopt if the variable is not an input.
+   */
+  inline std::optional<size_t> getInputIndex(const Variable& variable) const {
+    auto it = inputIndex.find(&variable);
+    if ( it == inputIndex.end() ) {
+      return std::nullopt;
+    }
+    return it->second;
+  }
+
+  /**
+   * @brief Computes the values of all nodes for the given input values.
+   */
+  inline void forward(const std::vector<double>& inputValues) {
+    if ( inputValues.size() != inputs.size() ) {
+      throw std::invalid_argument("CP: number of values does not match number of inputs of tape");
+    }
+    CP_COUNT(NODES, nodes.size());
+    values.resize(nodes.size());
+    for ( size_t i = 0; i < nodes.size(); i++ ) {
+      values[i] = compute(nodes[i], inputValues);
+    }
+  }
+
+  /**
+   * @brief Sets the input values for a lazy evaluation of individual outputs by evaluate().
+   */
+  inline void setInputs(const std::vector<double>& inputValues) {
+    if ( inputValues.size() != inputs.size() ) {
+      throw std::invalid_argument("CP: number of values does not match number of inputs of tape");
+    }
+    lazyInputs.assign(inputValues.begin(), inputValues.end());
+    values.resize(nodes.size());
+    stamps.resize(nodes.size(), 0);
+    epoch++;
+  }
+
+  /**
+   * @brief Computes the value of an output for the input values given by setInputs() and returns it.
+   *
+   * Only the nodes required for the output are computed and each node is computed at most once per call of setInputs(),
+   * so that nodes shared by several outputs, e.g. deduced variables, are reused. The second argument of a conjunction or
+   * disjunction and the branches of conditionals are only computed if needed.
+   */
+  inline double evaluate(size_t output) {
+    size_t root = outputs.at(output);
+    if ( stamps[root] != epoch ) {
+      lazyFrames.push_back({ root, 0 });
+    }
+    while ( !lazyFrames.empty() ) {
+      auto& [i, position] = lazyFrames.back();
+      auto& node = nodes[i];
+      if ( auto next = nextArgument(node, position) ) {
+        size_t j = arguments[node.first + next.value()];
+        if ( stamps[j] != epoch ) {
+          lazyFrames.push_back({ j, 0 });
+        }
+        continue;
+      }
+      values[i] = compute(node, lazyInputs);
+      stamps[i] = epoch;
+      lazyFrames.pop_back();
+    }
+    return values[root];
+  }
+
+  /**
+   * @brief Computes the value of a single node for the input values given by setInputs() and returns it.
+   *
+   * The arguments of the node must have been computed before. Different nodes may be computed concurrently.
+   */
+  inline double compute(size_t node) {
+    values[node] = compute(nodes[node], lazyInputs);
+    stamps[node] = epoch;
+    return values[node];
+  }
+
+  /**
+   * @brief Returns the number of times evaluate() skipped arguments which were not needed.
+   */
+  inline size_t getShortCircuits() const { return shortCircuits; };
+
+  /**
+   * @brief Returns the value of an output as computed by the last forward sweep.
+   */
+  inline double getValue(size_t output) const { return values.at(outputs.at(output)); };
+
+  /**
+   * @brief Computes the intervals of all nodes for the given intervals of the inputs.
+   *
+   * Infinite bounds are represented by std::numeric_limits<double>::lowest() and std::numeric_limits<double>::max().
+   */
+  inline void bounds(const std::vector<Interval>& inputIntervals) {
+    if ( inputIntervals.size() != inputs.size() ) {
+      throw std::invalid_argument("CP: number of intervals does not match number of inputs of tape");
+    }
+    CP_COUNT(NODES, nodes.size());
+    intervals.resize(nodes.size());
+    for ( size_t i = 0; i < nodes.size(); i++ ) {
+      auto [lowerBound, upperBound] = computeInterval(nodes[i], inputIntervals);
+      intervals[i] = {
+        std::clamp(lowerBound, std::numeric_limits<double>::lowest(), std::numeric_limits<double>::max()),
+        std::clamp(upperBound, std::numeric_limits<double>::lowest(), std::numeric_limits<double>::max())
+      };
+    }
+  }
+
+  /**
+   * @brief Computes the intervals of all nodes using the bounds of the input variables.
+   */
+  inline void bounds() {
+    std::vector<Interval> inputIntervals;
+    inputIntervals.reserve(inputs.size());
+    for ( auto variable : inputs ) {
+      inputIntervals.push_back({ variable->lowerBound, variable->upperBound });
+    }
+    bounds(inputIntervals);
+  }
+
+  /**
+   * @brief Narrows the intervals of the inputs to values for which the value of an output may be within a range and returns false if there are no such values.
+   *
+   * The intervals of the nodes required by the output are computed by a forward sweep, intersected with the range at the
+   * output, and propagated back to the inputs by a backward sweep (HC4-revise). Bounds of integer and boolean inputs are
+   * rounded. Nodes for which no backward rule is known, e.g. powers, leave their arguments unchanged.
+   *
+   * @param output The output, e.g. the violation of a constraint with range [0,0].
+   * @param range The range of values admitted for the output.
+   * @param inputIntervals The intervals of the inputs, which are narrowed.
+   */
+  inline bool narrow(size_t output, Interval range, std::vector<Interval>& inputIntervals) {
+    if ( inputIntervals.size() != inputs.size() ) {
+      throw std::invalid_argument("CP: number of intervals does not match number of inputs of tape");
+    }
+    auto& cone = getCone(output);
+    intervals.resize(nodes.size());
+    for ( size_t i : cone ) {
+      auto [lowerBound, upperBound] = computeInterval(nodes[i], inputIntervals);
+      intervals[i] = {
+        std::clamp(lowerBound, std::numeric_limits<double>::lowest(), std::numeric_limits<double>::max()),
+        std::clamp(upperBound, std::numeric_limits<double>::lowest(), std::numeric_limits<double>::max())
+      };
+    }
+    if ( !restrict(outputs.at(output), range) ) {
+      return false;
+    }
+    // all nodes using a node precede it in reverse postfix order
+    for ( auto it = cone.rbegin(); it != cone.rend(); it++ ) {
+      auto& node = nodes[*it];
+      if ( node.opcode == Opcode::input ) {
+        auto& interval = inputIntervals[(size_t)node.constant];
+        interval = { std::max(interval.lowerBound, intervals[*it].lowerBound), std::min(interval.upperBound, intervals[*it].upperBound) };
+      }
+      else if ( !narrowArguments(*it) ) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /**
+   * @brief Returns the interval of an output as computed by the last call of bounds().
+   */
+  inline Interval getBounds(size_t output) const { return intervals.at(outputs.at(output)); };
+
+  /**
+   * @brief Returns the gradient of the weighted sum of all outputs with respect to the inputs using a single backward sweep.
+   *
+   * Requires a preceding call of forward().
+   *
+   * @param weights The weight of each output.
+   */
+  inline std::vector<double> gradient(const std::vector<double>& weights) {
+    std::vector<double> result;
+    gradient(weights, result);
+    return result;
+  }
+
+  /**
+   * @brief Stores the gradient of the weighted sum of all outputs in result, which does not allocate memory if result and the tape were used before.
+   */
+  inline void gradient(const std::vector<double>& weights, std::vector<double>& result) {
+    if ( weights.size() != outputs.size() ) {
+      throw std::invalid_argument("CP: number of weights does not match number of outputs of tape");
+    }
+    if ( values.size() != nodes.size() ) {
+      throw std::logic_error("CP: backward sweep requires forward sweep");
+    }
+    adjoints.assign(nodes.size(), 0.0);
+    size_t last = 0;
+    for ( size_t i = 0; i < outputs.size(); i++ ) {
+      adjoints[outputs[i]] += weights[i];
+      last = std::max(last, outputs[i] + 1);
+    }
+
+    result.assign(inputs.size(), 0.0);
+    for ( size_t i = last; i-- > 0; ) {
+      if ( adjoints[i] == 0.0 ) {
+        continue;
+      }
+      if ( nodes[i].opcode == Opcode::input ) {
+        result[(size_t)nodes[i].constant] += adjoints[i];
+      }
+      else {
+        propagate(i);
+      }
+    }
+  }
+
+  /**
+   * @brief Returns the non-zero entries of the Jacobian of the outputs with respect to the inputs ordered by row.
+   *
+   * Each row is obtained by a backward sweep restricted to the nodes the respective output depends on.
+   * Requires a preceding call of forward().
+   */
+  inline std::vector<Entry> jacobian() {
+    CP_TRACE_SCOPE("Tape::jacobian");
+    if ( values.size() != nodes.size() ) {
+      throw std::logic_error("CP: backward sweep requires forward sweep");
+    }
+    std::vector<Entry> result;
+    adjoints.assign(nodes.size(), 0.0);
+    std::vector<size_t> visited(nodes.size(), 0);
+    std::vector<size_t> cone;
+    std::vector<size_t> stack;
+    for ( size_t row = 0; row < outputs.size(); row++ ) {
+      // collect all nodes the output depends on
+      cone.clear();
+      stack.push_back(outputs[row]);
+      visited[outputs[row]] = row + 1;
+      while ( !stack.empty() ) {
+        size_t i = stack.back();
+        stack.pop_back();
+        cone.push_back(i);
+        for ( size_t j = nodes[i].first; j < nodes[i].first + nodes[i].count; j++ ) {
+          if ( visited[arguments[j]] != row + 1 ) {
+            visited[arguments[j]] = row + 1;
+            stack.push_back(arguments[j]);
+          }
+        }
+      }
+      std::sort(cone.begin(), cone.end(), std::greater<size_t>());
+
+      adjoints[outputs[row]] = 1.0;
+      size_t begin = result.size();
+      for ( size_t i : cone ) {
+        if ( adjoints[i] != 0.0 ) {
+          if ( nodes[i].opcode == Opcode::input ) {
+            result.push_back({ row, (size_t)nodes[i].constant, adjoints[i] });
+          }
+          else {
+            propagate(i);
+          }
+        }
+        adjoints[i] = 0.0;
+      }
+      std::sort(result.begin() + (long)begin, result.end(), [](const Entry& lhs, const Entry& rhs) { return lhs.column < rhs.column; });
+    }
+    return result;
+  }
+
+private:
+  std::vector<Node> nodes;
+  std::vector<size_t> arguments;
+  std::vector<size_t> outputs;
+  std::vector<const Variable*> inputs;
+  std::unordered_map<const Variable*, size_t> inputIndex;
+  std::unordered_map<const Variable*, size_t> variableNodes; ///< Node of each input or deduced variable
+  std::vector<double> breakpoints; ///< Number of breakpoints followed by their x- and y-values for each piecewise-linear and step function
+  std::vector<const Table*> tables;
+  std::vector<const LinearConstraint*> linears;
+  std::vector<double> values;
+  std::vector<double> adjoints;
+  std::vector<Interval> intervals;
+  std::unordered_map<size_t, std::vector<size_t>> cones; ///< Nodes required by each output in increasing order
+  // lazy evaluation
+  struct LazyFrame {
+    size_t node;
+    size_t position; ///< Next argument to be considered
+  };
+  std::vector<LazyFrame> lazyFrames;
+  std::vector<double> lazyInputs;
+  std::vector<uint64_t> stamps; ///< Epoch in which the value of each node was computed
+  uint64_t epoch = 0;
+  size_t shortCircuits = 0;
+
+  inline const std::vector<size_t>& getCone(size_t output) {
+    if ( auto it = cones.find(output); it != cones.end() ) {
+      return it->second;
+    }
+    auto& cone = cones[output];
+    std::vector<size_t> stack = { outputs.at(output) };
+    std::unordered_map<size_t, bool> visited = { { stack.back(), true } };
+    while ( !stack.empty() ) {
+      size_t i = stack.back();
+      stack.pop_back();
+      cone.push_back(i);
+      for ( size_t j = nodes[i].first; j < nodes[i].first + nodes[i].count; j++ ) {
+        if ( visited.emplace(arguments[j], true).second ) {
+          stack.push_back(arguments[j]);
+        }
+      }
+    }
+    std::sort(cone.begin(), cone.end());
+    return cone;
+  }
+
+  /**
+   * @brief Intersects the interval of a node with a range, rounds the bounds of integer nodes, and returns false if the result is empty.
+   */
+  inline bool restrict(size_t i, Interval range) {
+    constexpr double tolerance = 1e-9;
+    auto& interval = intervals[i];
+    interval = { std::max(interval.lowerBound, range.lowerBound), std::min(interval.upperBound, range.upperBound) };
+    auto& node = nodes[i];
+    if ( isLogical(i) || ( node.opcode == Opcode::input && inputs[(size_t)node.constant]->type != Variable::Type::REAL ) ) {
+      interval = { std::ceil(interval.lowerBound - tolerance), std::floor(interval.upperBound + tolerance) };
+    }
+    if ( interval.lowerBound > interval.upperBound + tolerance ) {
+      return false;
+    }
+    interval.upperBound = std::max(interval.lowerBound, interval.upperBound);
+    return true;
+  }
+
+  /**
+   * @brief Returns true if the value of a node is a truth value, i.e. 0 or 1.
+   */
+  inline bool isLogical(size_t i) const {
+    switch ( nodes[i].opcode ) {
+      case Opcode::logical_not:
+      case Opcode::logical_and:
+      case Opcode::logical_or:
+      case Opcode::less_than:
+      case Opcode::less_or_equal:
+      case Opcode::greater_than:
+      case Opcode::greater_or_equal:
+      case Opcode::equal:
+      case Opcode::not_equal:
+      case Opcode::table:
+        return true;
+      case Opcode::input:
+        return inputs[(size_t)nodes[i].constant]->type == Variable::Type::BOOLEAN;
+      default:
+        return false;
+    }
+  }
+
+  /**
+   * @brief Narrows the intervals of the arguments of a node to values for which the value of the node may be within its interval.
+   */
+  inline bool narrowArguments(size_t i) {
+    constexpr double lowest = std::numeric_limits<double>::lowest();
+    constexpr double max = std::numeric_limits<double>::max();
+    auto& node = nodes[i];
+    Interval range = intervals[i];
+    auto index = [&](size_t j) { return arguments[node.first + j]; };
+    auto arg = [&](size_t j) { return intervals[index(j)]; };
+    // infinite bounds remain infinite
+    auto lowerSum = [=](double a, double b) { return ( a == lowest || b == lowest ) ? lowest : std::clamp(a + b, lowest, max); };
+    auto upperSum = [=](double a, double b) { return ( a == max || b == max ) ? max : std::clamp(a + b, lowest, max); };
+    auto scale = [=](double a, double factor) { return ( a == lowest || a == max ) ? ( ( a > 0 ) == ( factor > 0 ) ? max : lowest ) : std::clamp(a * factor, lowest, max); };
+    auto scaled = [&](Interval interval, double factor) -> Interval {
+      double lower = scale(interval.lowerBound, factor);
+      double upper = scale(interval.upperBound, factor);
+      return { std::min(lower, upper), std::max(lower, upper) };
+    };
+    auto isTrue = [](Interval interval) { return interval.lowerBound > 0.0 || interval.upperBound < 0.0; };
+    auto isFalse = [](Interval interval) { return interval.lowerBound == 0.0 && interval.upperBound == 0.0; };
+    // requires a truth value, a truth value different from zero is only enforced for logical nodes
+    auto require = [&](size_t j, bool value) {
+      if ( !value ) {
+        return restrict(index(j), { 0.0, 0.0 });
+      }
+      if ( isLogical(index(j)) ) {
+        return restrict(index(j), { 1.0, 1.0 });
+      }
+      return !isFalse(arg(j));
+    };
+    auto isPoint = [](Interval interval) { return interval.lowerBound == interval.upperBound; };
+
+    switch ( node.opcode ) {
+      case Opcode::negate:
+        return restrict(index(0), { -range.upperBound, -range.lowerBound });
+      case Opcode::add:
+        return restrict(index(0), { lowerSum(range.lowerBound, -arg(1).upperBound), upperSum(range.upperBound, -arg(1).lowerBound) })
+          && restrict(index(1), { lowerSum(range.lowerBound, -arg(0).upperBound), upperSum(range.upperBound, -arg(0).lowerBound) });
+      case Opcode::subtract:
+        return restrict(index(0), { lowerSum(range.lowerBound, arg(1).lowerBound), upperSum(range.upperBound, arg(1).upperBound) })
+          && restrict(index(1), { lowerSum(arg(0).lowerBound, -range.upperBound), upperSum(arg(0).upperBound, -range.lowerBound) });
+      case Opcode::multiply:
+        for ( size_t j = 0; j < 2; j++ ) {
+          if ( isPoint(arg(1-j)) && arg(1-j).lowerBound != 0.0 && !restrict(index(j), scaled(range, 1.0 / arg(1-j).lowerBound)) ) {
+            return false;
+          }
+        }
+        return true;
+      case Opcode::divide:
+        if ( isPoint(arg(1)) && arg(1).lowerBound != 0.0 ) {
+          return restrict(index(0), scaled(range, arg(1).lowerBound));
+        }
+        return true;
+      case Opcode::positive_part:
+        if ( range.lowerBound > 0.0 ) {
+          return restrict(index(0), range);
+        }
+        return restrict(index(0), { lowest, range.upperBound });
+      case Opcode::absolute:
+        return restrict(index(0), { -range.upperBound, range.upperBound });
+      case Opcode::logical_not:
+        if ( isTrue(range) ) return require(0, false);
+        if ( isFalse(range) ) return require(0, true);
+        return true;
+      case Opcode::logical_and:
+      case Opcode::logical_or:
+      {
+        // the dominant value is false for conjunctions and true for disjunctions
+        bool dominant = ( node.opcode == Opcode::logical_or );
+        bool isDominant = dominant ? isTrue(range) : isFalse(range);
+        bool isRecessive = dominant ? isFalse(range) : isTrue(range);
+        if ( isRecessive ) {
+          return require(0, !dominant) && require(1, !dominant);
+        }
+        if ( isDominant ) {
+          for ( size_t j = 0; j < 2; j++ ) {
+            if ( ( dominant ? isFalse(arg(1-j)) : isTrue(arg(1-j)) ) && !require(j, dominant) ) {
+              return false;
+            }
+          }
+        }
+        return true;
+      }
+      case Opcode::less_than:
+      case Opcode::less_or_equal:
+      case Opcode::greater_than:
+      case Opcode::greater_or_equal:
+      {
+        if ( !isTrue(range) && !isFalse(range) ) {
+          return true;
+        }
+        // ensure arg(smaller) <= arg(larger)
+        bool less = ( node.opcode == Opcode::less_than || node.opcode == Opcode::less_or_equal );
+        size_t smaller = ( less == isTrue(range) ) ? 0 : 1;
+        size_t larger = 1 - smaller;
+        return restrict(index(smaller), { lowest, arg(larger).upperBound }) && restrict(index(larger), { arg(smaller).lowerBound, max });
+      }
+      case Opcode::equal:
+      case Opcode::not_equal:
+        if ( ( node.opcode == Opcode::equal ) ? isTrue(range) : isFalse(range) ) {
+          return restrict(index(0), arg(1)) && restrict(index(1), arg(0));
+        }
+        return true;
+      case Opcode::min:
+        for ( size_t j = 0; j < node.count; j++ ) {
+          if ( !restrict(index(j), { range.lowerBound, max }) ) {
+            return false;
+          }
+        }
+        return true;
+      case Opcode::max:
+        for ( size_t j = 0; j < node.count; j++ ) {
+          if ( !restrict(index(j), { lowest, range.upperBound }) ) {
+            return false;
+          }
+        }
+        return true;
+      case Opcode::if_then_else:
+        if ( isTrue(arg(0)) ) return restrict(index(1), range);
+        if ( isFalse(arg(0)) ) return restrict(index(2), range);
+        return true;
+      case Opcode::table:
+      {
+        if ( !isTrue(range) ) {
+          return true;
+        }
+        std::vector<Interval> columns(node.count);
+        for ( size_t j = 0; j < node.count; j++ ) {
+          columns[j] = arg(j);
+        }
+        if ( !tables[(size_t)node.constant]->propagate(columns) ) {
+          return false;
+        }
+        for ( size_t j = 0; j < node.count; j++ ) {
+          if ( !restrict(index(j), columns[j]) ) {
+            return false;
+          }
+        }
+        return true;
+      }
+      case Opcode::linear:
+      {
+        // the activity of all other terms is the total activity without the term, infinite terms are counted separately
+        auto& coefficients = linears[(size_t)node.constant]->coefficients;
+        double minimum = 0.0, maximum = 0.0;
+        size_t infiniteMinima = 0, infiniteMaxima = 0;
+        auto term = [&](size_t j) { return scaled(arg(j), coefficients[j]); };
+        for ( size_t j = 0; j < node.count; j++ ) {
+          auto [lower, upper] = term(j);
+          if ( lower == lowest ) {
+            infiniteMinima++;
+          }
+          else {
+            minimum += lower;
+          }
+          if ( upper == max ) {
+            infiniteMaxima++;
+          }
+          else {
+            maximum += upper;
+          }
+        }
+        for ( size_t j = 0; j < node.count; j++ ) {
+          if ( coefficients[j] == 0.0 ) {
+            continue;
+          }
+          auto [lower, upper] = term(j);
+          size_t otherInfiniteMinima = infiniteMinima - ( lower == lowest );
+          size_t otherInfiniteMaxima = infiniteMaxima - ( upper == max );
+          double otherMinimum = otherInfiniteMinima ? lowest : minimum - ( lower == lowest ? 0.0 : lower );
+          double otherMaximum = otherInfiniteMaxima ? max : maximum - ( upper == max ? 0.0 : upper );
+          Interval residual = { lowerSum(range.lowerBound, -otherMaximum), upperSum(range.upperBound, -otherMinimum) };
+          if ( !restrict(index(j), scaled(residual, 1.0 / coefficients[j])) ) {
+            return false;
+          }
+        }
+        return true;
+      }
+      default:
+        return true;
+    }
+  }
+
+  /**
+   * @brief Returns the next argument required for the lazy evaluation of a node and advances the position, or std::nullopt if all required arguments are computed.
+   */
+  inline std::optional<size_t> nextArgument(const Node& node, size_t& position) {
+    auto arg = [&](size_t i) { return values[arguments[node.first + i]]; };
+    if ( position >= node.count ) {
+      return std::nullopt;
+    }
+    switch ( node.opcode ) {
+      case Opcode::logical_and:
+      case Opcode::logical_or:
+        if ( position == 1 && ( arg(0) != 0.0 ) == ( node.opcode == Opcode::logical_or ) ) {
+          shortCircuits++;
+          position = node.count;
+          return std::nullopt;
+        }
+        break;
+      case Opcode::if_then_else:
+        if ( position == 1 ) {
+          shortCircuits++;
+          position = node.count;
+          return arg(0) ? 1 : 2;
+        }
+        break;
+      case Opcode::n_ary_if:
+        // conditions are at even positions followed by their values, the last argument is the default value
+        if ( position % 2 == 1 ) {
+          if ( arg(position - 1) ) {
+            shortCircuits += ( position + 1 < node.count - 1 );
+            size_t selected = position;
+            position = node.count;
+            return selected;
+          }
+          position++;
+        }
+        break;
+      default:
+        break;
+    }
+    return position++;
+  }
+
+  inline size_t emit(Opcode opcode, std::initializer_list<size_t> args, double constant = 0.0) {
+    nodes.push_back({ opcode, arguments.size(), args.size(), constant });
+    arguments.insert(arguments.end(), args);
+    return nodes.size() - 1;
+  }
+
+  inline size_t emit(Opcode opcode, const std::vector<size_t>& args, double constant = 0.0) {
+    nodes.push_back({ opcode, arguments.size(), args.size(), constant });
+    arguments.insert(arguments.end(), args.begin(), args.end());
+    return nodes.size() - 1;
+  }
+
+  inline static Opcode opcode(const Expression& expression) {
+    switch ( expression._operator ) {
+      case Expression::Operator::negate: return Opcode::negate;
+      case Expression::Operator::logical_not: return Opcode::logical_not;
+      case Expression::Operator::logical_and: return Opcode::logical_and;
+      case Expression::Operator::logical_or: return Opcode::logical_or;
+      case Expression::Operator::add: return Opcode::add;
+      case Expression::Operator::subtract: return Opcode::subtract;
+      case Expression::Operator::multiply: return Opcode::multiply;
+      case Expression::Operator::divide: return Opcode::divide;
+      case Expression::Operator::less_than: return Opcode::less_than;
+      case Expression::Operator::less_or_equal: return Opcode::less_or_equal;
+      case Expression::Operator::greater_than: return Opcode::greater_than;
+      case Expression::Operator::greater_or_equal: return Opcode::greater_or_equal;
+      case Expression::Operator::equal: return Opcode::equal;
+      case Expression::Operator::not_equal: return Opcode::not_equal;
+      case Expression::Operator::custom:
+      {
+        auto& name = Expression::customOperators[std::get<size_t>(expression.operands.front())];
+        if ( name == "min" ) return Opcode::min;
+        if ( name == "max" ) return Opcode::max;
+        if ( name == "if_then_else" ) return Opcode::if_then_else;
+        if ( name == "n_ary_if" ) return Opcode::n_ary_if;
+        if ( name == "pow" ) return Opcode::pow;
+        if ( name == "sqrt" ) return Opcode::sqrt;
+        if ( name == "cbrt" ) return Opcode::cbrt;
+        if ( name == "piecewise_linear" ) return Opcode::piecewise_linear;
+        if ( name == "step" ) return Opcode::step;
+        throw std::logic_error("CP: unsupported custom operator '" + name + "'");
+      }
+      default:
+        throw std::logic_error("CP: unexpected operator");
+    }
+  }
+
+  /**
+   * @brief Compiles an operand without recursion and returns the index of the resulting node.
+   */
+  inline size_t compile(const Operand& operand) {
+    struct Frame {
+      const Expression* expression;
+      const Variable* deduced; ///< Variable deduced from the expression, or nullptr
+      size_t next; ///< Next operand to be compiled
+      size_t base; ///< Size of the result stack when the frame was created
+    };
+    std::vector<Frame> frames;
+    std::vector<size_t> results;
+
+    // compiles leaves immediately and pushes frames for expressions
+    auto visit = [&](const Operand& term) {
+      if ( std::holds_alternative<double>(term) ) {
+        results.push_back( emit(Opcode::constant, {}, std::get<double>(term)) );
+      }
+      else if ( std::holds_alternative<std::reference_wrapper<const Variable>>(term) ) {
+        auto& variable = std::get<std::reference_wrapper<const Variable>>(term).get();
+        if ( auto it = variableNodes.find(&variable); it != variableNodes.end() ) {
+          results.push_back(it->second);
+        }
+        else if ( variable.deducedFrom ) {
+          frames.push_back({ variable.deducedFrom.get(), &variable, 0, results.size() });
+        }
+        else {
+          inputIndex[&variable] = inputs.size();
+          inputs.push_back(&variable);
+          variableNodes[&variable] = emit(Opcode::input, {}, (double)(inputs.size() - 1));
+          results.push_back(variableNodes[&variable]);
+        }
+      }
+      else if ( std::holds_alternative<Expression>(term) ) {
+        frames.push_back({ &std::get<Expression>(term), nullptr, 0, results.size() });
+      }
+      else {
+        throw std::logic_error("CP: unexpected operand");
+      }
+    };
+
+    visit(operand);
+    while ( !frames.empty() ) {
+      auto& frame = frames.back();
+      auto& operands = frame.expression->operands;
+      std::optional<Opcode> code;
+      if ( frame.expression->_operator != Expression::Operator::none ) {
+        code = opcode(*frame.expression);
+      }
+      if ( frame.next == 0 && frame.expression->_operator == Expression::Operator::custom ) {
+        frame.next = 1; // skip index of custom operator
+      }
+      // breakpoints are stored separately and only the argument is compiled
+      size_t end = ( code == Opcode::piecewise_linear || code == Opcode::step ) ? 2 : operands.size();
+      if ( frame.next < end ) {
+        visit(operands[frame.next++]);
+        continue;
+      }
+
+      size_t node;
+      if ( !code ) {
+        node = results.back();
+      }
+      else if ( code == Opcode::piecewise_linear || code == Opcode::step ) {
+        size_t n = operands.size() / 2 - 1;
+        node = emit(code.value(), { results.back() }, (double)breakpoints.size());
+        breakpoints.push_back((double)n);
+        for ( size_t i = 2; i < operands.size(); i += 2 ) {
+          breakpoints.push_back( std::get<double>(operands[i]) );
+        }
+        for ( size_t i = 3; i < operands.size(); i += 2 ) {
+          breakpoints.push_back( std::get<double>(operands[i]) );
+        }
+      }
+      else {
+        nodes.push_back({ code.value(), arguments.size(), results.size() - frame.base, 0.0 });
+        arguments.insert(arguments.end(), results.begin() + (long)frame.base, results.end());
+        node = nodes.size() - 1;
+      }
+      results.resize(frame.base);
+      results.push_back(node);
+      if ( frame.deduced ) {
+        variableNodes[frame.deduced] = node;
+      }
+      frames.pop_back();
+    }
+    return results.back();
+  }
+
+  inline double compute(const Node& node, const std::vector<double>& inputValues) const {
+    auto arg = [&](size_t i) { return values[arguments[node.first + i]]; };
+    switch ( node.opcode ) {
+      case Opcode::constant: return node.constant;
+      case Opcode::input: return inputValues[(size_t)node.constant];
+      case Opcode::negate: return -arg(0);
+      case Opcode::logical_not: return !arg(0);
+      case Opcode::logical_and: return arg(0) && arg(1);
+      case Opcode::logical_or: return arg(0) || arg(1);
+      case Opcode::add: return arg(0) + arg(1);
+      case Opcode::subtract: return arg(0) - arg(1);
+      case Opcode::multiply: return arg(0) * arg(1);
+      case Opcode::divide: return arg(0) / arg(1);
+      case Opcode::less_than: return arg(0) < arg(1);
+      case Opcode::less_or_equal: return arg(0) <= arg(1);
+      case Opcode::greater_than: return arg(0) > arg(1);
+      case Opcode::greater_or_equal: return arg(0) >= arg(1);
+      case Opcode::equal: return arg(0) == arg(1);
+      case Opcode::not_equal: return arg(0) != arg(1);
+      case Opcode::min: return arg(select(node));
+      case Opcode::max: return arg(select(node));
+      case Opcode::if_then_else: return arg(select(node));
+      case Opcode::n_ary_if: return arg(select(node));
+      case Opcode::pow: return std::pow(arg(0), arg(1));
+      case Opcode::sqrt: return std::sqrt(arg(0));
+      case Opcode::cbrt: return std::cbrt(arg(0));
+      case Opcode::piecewise_linear: return evaluateBreakpoints(node, arg(0));
+      case Opcode::step: return evaluateBreakpoints(node, arg(0));
+      case Opcode::table: return tables[(size_t)node.constant]->isSatisfied(arg);
+      case Opcode::linear:
+      {
+        auto& coefficients = linears[(size_t)node.constant]->coefficients;
+        double sum = 0.0;
+        for ( size_t i = 0; i < node.count; i++ ) {
+          sum += coefficients[i] * arg(i);
+        }
+        return sum;
+      }
+      case Opcode::positive_part: return std::max(0.0, arg(0));
+      case Opcode::absolute: return std::abs(arg(0));
+    }
+    throw std::logic_error("CP: unexpected opcode");
+  }
+
+  /**
+   * @brief Returns the number of breakpoints and pointers to the x- and y-values of a piecewise-linear or step function.
+   */
+  inline std::tuple<size_t, const double*, const double*> getBreakpoints(const Node& node) const {
+    size_t offset = (size_t)node.constant;
+    size_t n = (size_t)breakpoints[offset];
+    return { n, &breakpoints[offset + 1], &breakpoints[offset + 1 + n] };
+  }
+
+  /**
+   * @brief Returns the number of breakpoints with x-value smaller than or equal to x using binary search.
+   */
+  inline static size_t segment(size_t n, const double* xs, double x) {
+    return (size_t)(std::upper_bound(xs, xs + n, x) - xs);
+  }
+
+  inline double evaluateBreakpoints(const Node& node, double x) const {
+    auto [n, xs, ys] = getBreakpoints(node);
+    size_t k = segment(n, xs, x);
+    if ( k == 0 ) {
+      return ys[0];
+    }
+    if ( k == n || node.opcode == Opcode::step ) {
+      return ys[k-1];
+    }
+    return ys[k-1] + ( ys[k] - ys[k-1] ) * ( x - xs[k-1] ) / ( xs[k] - xs[k-1] );
+  }
+
+  /**
+   * @brief Returns the slope of a piecewise-linear function at x.
+   */
+  inline double slope(const Node& node, double x) const {
+    auto [n, xs, ys] = getBreakpoints(node);
+    size_t k = segment(n, xs, x);
+    if ( k == 0 || k == n ) {
+      return 0.0;
+    }
+    return ( ys[k] - ys[k-1] ) / ( xs[k] - xs[k-1] );
+  }
+
+  inline Interval computeInterval(const Node& node, const std::vector<Interval>& inputIntervals) const {
+    constexpr double lowest = std::numeric_limits<double>::lowest();
+    constexpr double max = std::numeric_limits<double>::max();
+    auto arg = [&](size_t i) { return intervals[arguments[node.first + i]]; };
+    auto hull = [](Interval lhs, Interval rhs) -> Interval { return { std::min(lhs.lowerBound, rhs.lowerBound), std::max(lhs.upperBound, rhs.upperBound) }; };
+    // intervals of truth values
+    auto isTrue = [](Interval interval) { return interval.lowerBound > 0.0 || interval.upperBound < 0.0; };
+    auto isFalse = [](Interval interval) { return interval.lowerBound == 0.0 && interval.upperBound == 0.0; };
+    auto truth = [](bool certainlyTrue, bool certainlyFalse) -> Interval { return { certainlyTrue ? 1.0 : 0.0, certainlyFalse ? 0.0 : 1.0 }; };
+    auto extremes = [](double a, double b, double c, double d) -> Interval { return { std::min({a, b, c, d}), std::max({a, b, c, d}) }; };
+
+    switch ( node.opcode ) {
+      case Opcode::constant: return { node.constant, node.constant };
+      case Opcode::input: return inputIntervals[(size_t)node.constant];
+      case Opcode::negate: return { -arg(0).upperBound, -arg(0).lowerBound };
+      case Opcode::logical_not: return truth( isFalse(arg(0)), isTrue(arg(0)) );
+      case Opcode::logical_and: return truth( isTrue(arg(0)) && isTrue(arg(1)), isFalse(arg(0)) || isFalse(arg(1)) );
+      case Opcode::logical_or: return truth( isTrue(arg(0)) || isTrue(arg(1)), isFalse(arg(0)) && isFalse(arg(1)) );
+      case Opcode::add: return { arg(0).lowerBound + arg(1).lowerBound, arg(0).upperBound + arg(1).upperBound };
+      case Opcode::subtract: return { arg(0).lowerBound - arg(1).upperBound, arg(0).upperBound - arg(1).lowerBound };
+      case Opcode::multiply:
+        return extremes(
+          arg(0).lowerBound * arg(1).lowerBound, arg(0).lowerBound * arg(1).upperBound,
+          arg(0).upperBound * arg(1).lowerBound, arg(0).upperBound * arg(1).upperBound
+        );
+      case Opcode::divide:
+        if ( arg(1).lowerBound <= 0.0 && arg(1).upperBound >= 0.0 ) {
+          return { lowest, max };
+        }
+        return extremes(
+          arg(0).lowerBound / arg(1).lowerBound, arg(0).lowerBound / arg(1).upperBound,
+          arg(0).upperBound / arg(1).lowerBound, arg(0).upperBound / arg(1).upperBound
+        );
+      case Opcode::less_than: return truth( arg(0).upperBound < arg(1).lowerBound, arg(0).lowerBound >= arg(1).upperBound );
+      case Opcode::less_or_equal: return truth( arg(0).upperBound <= arg(1).lowerBound, arg(0).lowerBound > arg(1).upperBound );
+      case Opcode::greater_than: return truth( arg(0).lowerBound > arg(1).upperBound, arg(0).upperBound <= arg(1).lowerBound );
+      case Opcode::greater_or_equal: return truth( arg(0).lowerBound >= arg(1).upperBound, arg(0).upperBound < arg(1).lowerBound );
+      case Opcode::equal:
+      case Opcode::not_equal:
+      {
+        bool same = arg(0).lowerBound == arg(0).upperBound && arg(1).lowerBound == arg(1).upperBound && arg(0).lowerBound == arg(1).lowerBound;
+        bool disjoint = arg(0).upperBound < arg(1).lowerBound || arg(1).upperBound < arg(0).lowerBound;
+        return node.opcode == Opcode::equal ? truth(same, disjoint) : truth(disjoint, same);
+      }
+      case Opcode::min:
+      case Opcode::max:
+      {
+        Interval result = arg(0);
+        for ( size_t i = 1; i < node.count; i++ ) {
+          if ( node.opcode == Opcode::min ) {
+            result = { std::min(result.lowerBound, arg(i).lowerBound), std::min(result.upperBound, arg(i).upperBound) };
+          }
+          else {
+            result = { std::max(result.lowerBound, arg(i).lowerBound), std::max(result.upperBound, arg(i).upperBound) };
+          }
+        }
+        return result;
+      }
+      case Opcode::if_then_else:
+        if ( isTrue(arg(0)) ) return arg(1);
+        if ( isFalse(arg(0)) ) return arg(2);
+        return hull(arg(1), arg(2));
+      case Opcode::n_ary_if:
+      {
+        std::optional<Interval> result;
+        for ( size_t i = 0; i + 1 < node.count; i += 2 ) {
+          if ( isFalse(arg(i)) ) {
+            continue;
+          }
+          result = result ? hull(result.value(), arg(i+1)) : arg(i+1);
+          if ( isTrue(arg(i)) ) {
+            return result.value();
+          }
+        }
+        return result ? hull(result.value(), arg(node.count - 1)) : arg(node.count - 1);
+      }
+      case Opcode::pow:
+      {
+        auto [base, exponent] = std::make_pair(arg(0), arg(1));
+        if ( exponent.lowerBound != exponent.upperBound ) {
+          if ( base.lowerBound >= 1.0 && exponent.lowerBound >= 0.0 ) {
+            return { std::pow(base.lowerBound, exponent.lowerBound), std::pow(base.upperBound, exponent.upperBound) };
+          }
+          return { lowest, max };
+        }
+        double e = exponent.lowerBound;
+        double lower = std::pow(base.lowerBound, e);
+        double upper = std::pow(base.upperBound, e);
+        if ( base.lowerBound >= 0.0 ) {
+          if ( e < 0.0 && base.lowerBound == 0.0 ) {
+            return { upper, max };
+          }
+          return { std::min(lower, upper), std::max(lower, upper) };
+        }
+        if ( e >= 0.0 && e == std::floor(e) ) {
+          if ( std::fmod(e, 2.0) != 0.0 ) {
+            return { lower, upper };
+          }
+          if ( base.upperBound <= 0.0 ) {
+            return { upper, lower };
+          }
+          return { 0.0, std::max(lower, upper) };
+        }
+        return { lowest, max };
+      }
+      case Opcode::sqrt: return { std::sqrt(std::max(0.0, arg(0).lowerBound)), std::sqrt(std::max(0.0, arg(0).upperBound)) };
+      case Opcode::cbrt: return { std::cbrt(arg(0).lowerBound), std::cbrt(arg(0).upperBound) };
+      case Opcode::piecewise_linear:
+      case Opcode::step:
+      {
+        // the extremes are attained at the bounds or at breakpoints in between
+        auto [n, xs, ys] = getBreakpoints(node);
+        double lower = evaluateBreakpoints(node, arg(0).lowerBound);
+        double upper = evaluateBreakpoints(node, arg(0).upperBound);
+        Interval result = { std::min(lower, upper), std::max(lower, upper) };
+        for ( size_t k = segment(n, xs, arg(0).lowerBound); k < n && xs[k] <= arg(0).upperBound; k++ ) {
+          result = hull(result, { ys[k], ys[k] });
+        }
+        return result;
+      }
+      case Opcode::table:
+      {
+        std::vector<Interval> columns(node.count);
+        bool fixed = true;
+        for ( size_t i = 0; i < node.count; i++ ) {
+          columns[i] = arg(i);
+          fixed = fixed && columns[i].lowerBound == columns[i].upperBound;
+        }
+        if ( !tables[(size_t)node.constant]->propagate(columns) ) {
+          return { 0.0, 0.0 };
+        }
+        return { fixed ? 1.0 : 0.0, 1.0 };
+      }
+      case Opcode::linear:
+      {
+        auto& coefficients = linears[(size_t)node.constant]->coefficients;
+        Interval result = { 0.0, 0.0 };
+        for ( size_t i = 0; i < node.count; i++ ) {
+          double lower = coefficients[i] * arg(i).lowerBound;
+          double upper = coefficients[i] * arg(i).upperBound;
+          result.lowerBound += std::min(lower, upper);
+          result.upperBound += std::max(lower, upper);
+        }
+        return result;
+      }
+      case Opcode::positive_part: return { std::max(0.0, arg(0).lowerBound), std::max(0.0, arg(0).upperBound) };
+      case Opcode::absolute:
+        if ( arg(0).lowerBound >= 0.0 ) return arg(0);
+        if ( arg(0).upperBound <= 0.0 ) return { -arg(0).upperBound, -arg(0).lowerBound };
+        return { 0.0, std::max(-arg(0).lowerBound, arg(0).upperBound) };
+    }
+    throw std::logic_error("CP: unexpected opcode");
+  }
+
+  /**
+   * @brief Returns the argument determining the value of a min, max, or conditional node.
+   */
+  inline size_t select(const Node& node) const {
+    auto arg = [&](size_t i) { return values[arguments[node.first + i]]; };
+    switch ( node.opcode ) {
+      case Opcode::min:
+      case Opcode::max:
+      {
+        size_t selected = 0;
+        for ( size_t i = 1; i < node.count; i++ ) {
+          if ( node.opcode == Opcode::min ? arg(i) < arg(selected) : arg(i) > arg(selected) ) {
+            selected = i;
+          }
+        }
+        return selected;
+      }
+      case Opcode::if_then_else:
+        return arg(0) ? 1 : 2;
+      case Opcode::n_ary_if:
+        for ( size_t i = 0; i + 1 < node.count; i += 2 ) {
+          if ( arg(i) ) {
+            return i + 1;
+          }
+        }
+        return node.count - 1;
+      default:
+        throw std::logic_error("CP: unexpected opcode");
+    }
+  }
+
+  /**
+   * @brief Propagates the adjoint of a node to its arguments.
+   */
+  inline void propagate(size_t i) {
+    auto& node = nodes[i];
+    double adjoint = adjoints[i];
+    auto arg = [&](size_t j) { return values[arguments[node.first + j]]; };
+    auto accumulate = [&](size_t j, double derivative) { adjoints[arguments[node.first + j]] += adjoint * derivative; };
+    switch ( node.opcode ) {
+      case Opcode::negate:
+        accumulate(0, -1.0);
+        break;
+      case Opcode::add:
+        accumulate(0, 1.0);
+        accumulate(1, 1.0);
+        break;
+      case Opcode::subtract:
+        accumulate(0, 1.0);
+        accumulate(1, -1.0);
+        break;
+      case Opcode::multiply:
+        accumulate(0, arg(1));
+        accumulate(1, arg(0));
+        break;
+      case Opcode::divide:
+        accumulate(0, 1.0 / arg(1));
+        accumulate(1, -arg(0) / (arg(1) * arg(1)));
+        break;
+      case Opcode::min:
+      case Opcode::max:
+      case Opcode::if_then_else:
+      case Opcode::n_ary_if:
+        accumulate(select(node), 1.0);
+        break;
+      case Opcode::pow:
+        accumulate(0, arg(1) * std::pow(arg(0), arg(1) - 1.0));
+        if ( arg(0) > 0.0 ) {
+          accumulate(1, values[i] * std::log(arg(0)));
+        }
+        break;
+      case Opcode::sqrt:
+        accumulate(0, 0.5 / values[i]);
+        break;
+      case Opcode::cbrt:
+        accumulate(0, 1.0 / (3.0 * values[i] * values[i]));
+        break;
+      case Opcode::piecewise_linear:
+        accumulate(0, slope(node, arg(0)));
+        break;
+      case Opcode::linear:
+        for ( size_t j = 0; j < node.count; j++ ) {
+          accumulate(j, linears[(size_t)node.constant]->coefficients[j]);
+        }
+        break;
+      case Opcode::positive_part:
+        accumulate(0, arg(0) > 0.0 ? 1.0 : 0.0);
+        break;
+      case Opcode::absolute:
+        accumulate(0, arg(0) > 0.0 ? 1.0 : ( arg(0) < 0.0 ? -1.0 : 0.0 ) );
+        break;
+      default:
+        // logical operators and comparisons are piecewise constant
+        break;
+    }
+  }
+};
+
+} // end namespace CP
@@ -0,0 +1,123 @@
+ /**
+ ******************************************************************************
+ *
+ *  Fixed-size thread pool
+ *
+ ******************************************************************************
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace CP {
+
+/*******************************************
+ * ThreadPool
+ ******************************************/
+
+/**
+ * @brief Executes tasks on a fixed number of worker threads.
+ */
+class ThreadPool {
+public:
+  /**
+   * @brief Creates a pool with the given number of threads, or one thread per hardware thread if zero.
+   */
+  inline ThreadPool(size_t threads = 0) {
+    if ( threads == 0 ) {
+      threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+    }
+    workers.reserve(threads);
+    for ( size_t i = 0; i < threads; i++ ) {
+      workers.emplace_back( [this]() { work(); } );
+    }
+  }
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  inline ~ThreadPool() {
+    {
+      std::lock_guard lock(mutex);
+      stopping = true;
+    }
+    available.notify_all();
+    for ( auto& worker : workers ) {
+      worker.join();
+    }
+  }
+
+  inline size_t size() const { return workers.size(); };
+
+  /**
+   * @brief Calls function(task) for each task in {0, ..., tasks-1} on the worker threads and waits until all calls are completed.
+   *
+   * If a call throws an exception, the first exception is rethrown after all calls are completed.
+   */
+  template<typename Function>
+  inline void run(size_t tasks, Function&& function) {
+    std::mutex completion;
+    std::condition_variable completed;
+    size_t remaining = tasks;
+    std::exception_ptr exception;
+    {
+      std::lock_guard lock(mutex);
+      for ( size_t task = 0; task < tasks; task++ ) {
+        queue.push( [&, task]() {
+          try {
+            function(task);
+          }
+          catch (...) {
+            std::lock_guard guard(completion);
+            if ( !exception ) {
+              exception = std::current_exception();
+            }
+          }
+          std::lock_guard guard(completion);
+          if ( --remaining == 0 ) {
+            completed.notify_one();
+          }
+        } );
+      }
+    }
+    available.notify_all();
+    std::unique_lock lock(completion);
+    completed.wait(lock, [&]() { return remaining == 0; });
+    if ( exception ) {
+      std::rethrow_exception(exception);
+    }
+  }
+
+private:
+  std::vector<std::thread> workers;
+  std::queue< std::function<void()> > queue;
+  std::mutex mutex;
+  std::condition_variable available;
+  bool stopping = false;
+
+  inline void work() {
+    while ( true ) {
+      std::function<void()> task;
+      {
+        std::unique_lock lock(mutex);
+        available.wait(lock, [this]() { return stopping || !queue.empty(); });
+        if ( stopping && queue.empty() ) {
+          return;
+        }
+        task = std::move(queue.front());
+        queue.pop();
+      }
+      task();
+    }
+  }
+};
+
+} // end namespace CP